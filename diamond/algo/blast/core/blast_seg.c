@@ -1305,6 +1305,8 @@ double lnfact[] =
    82108.927837 
   }; 
 
+const int kSegLnfactSize = sizeof(lnfact)/sizeof(*lnfact);   /**< number of entries in lnfact. */
+
 
 const int kProtAlphabet = 2;   /**< identifies protein alphabet (FIXME: needed?). */
 
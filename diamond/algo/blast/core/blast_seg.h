@@ -57,6 +57,10 @@ typedef struct SegParameters
    Int4 maxbogus;
   } SegParameters;
 
+/** Natural logarithms of n! for n < kSegLnfactSize, as used by seg. */
+extern double lnfact[];
+extern const int kSegLnfactSize;
+
 /** Allocated SeqParameter struct for proteins and fills with default values.
  * @return pointer to SegParameters
  */
@@ -30,6 +30,7 @@ Author: Benjamin Buchfink
 #include "../util/map.h"
 #include "align_read.h"
 #include "../util/task_queue.h"
+#include "../util/radix_sort.h"
 
 using std::vector;
 using boost::thread;
@@ -105,7 +106,7 @@ void align_queries(typename Trace_pt_buffer<_locr,_locl>::Vector &trace_pts, con
 #pragma omp parallel
 	{
 		Statistics st;
-		size_t i;
+		size_t i = 0;
 		while(queue.get(i) && !exception_state()) {
 			try {
 				size_t begin = p[i], end = p[i+1];
@@ -128,26 +129,59 @@ void align_queries(typename Trace_pt_buffer<_locr,_locl>::Vector &trace_pts, con
 	exception_state.sync();
 }
 
+/* Query ids are dense, so the trace points are grouped by a stable counting
+   sort instead of a comparison sort. */
+
+template<typename _locr, typename _locl>
+void group_by_query(typename Trace_pt_buffer<_locr,_locl>::Vector &v)
+{
+	if(v.size() < 2)
+		return;
+	unsigned q_min = std::numeric_limits<unsigned>::max(), q_max = 0;
+	for(typename Trace_pt_buffer<_locr,_locl>::Vector::const_iterator i=v.begin();i!=v.end();++i) {
+		q_min = std::min(q_min, i->query_);
+		q_max = std::max(q_max, i->query_);
+	}
+	typename Trace_pt_buffer<_locr,_locl>::Vector buffer (v.size());
+	counting_sort(&v.front(), &v.front() + v.size(), &buffer.front(), q_min, q_max, program_options::threads(), typename hit<_locr,_locl>::template Query_id<1> ());
+}
+
+template<typename _locr, typename _locl>
+void load_trace_pts(const Trace_pt_buffer<_locr,_locl> *trace_pts, typename Trace_pt_buffer<_locr,_locl>::Vector *v, unsigned bin)
+{
+	try {
+		trace_pts->load(*v, bin);
+		group_by_query<_locr,_locl>(*v);
+	} catch(std::exception &e) {
+		exception_state.set(e);
+	}
+}
+
+/* The next bin is loaded and sorted in the background while the current one is aligned. */
+
 template<typename _val, typename _locr, typename _locl>
 void align_queries(const Trace_pt_buffer<_locr,_locl> &trace_pts, const vector<Output_stream*> &output_files)
 {
-	typename Trace_pt_buffer<_locr,_locl>::Vector v;
+	typename Trace_pt_buffer<_locr,_locl>::Vector v[2];
 	size_t q_len = max_id_len(query_ids::get()), ref_len = max_id_len(ref_ids::get());
 	log_stream << "ID len " << ref_len << ' ' << q_len << endl;
 	Output_stack<_val>::get().set_line_sizes(q_len, ref_len, query_seqs<_val>::data_->len_bounds(0).second);
 	//ref_bam_map.init(ref_seqs<_val>::get().get_length());
+	task_timer timer ("Loading trace points", false);
+	load_trace_pts(&trace_pts, &v[0], 0);
+	exception_state.sync();
 	for(unsigned bin=0;bin<trace_pts.bins();++bin) {
 		log_stream << "Processing query bin " << bin+1 << '/' << trace_pts.bins() << '\n';
-		task_timer timer ("Loading trace points", false);
-		trace_pts.load(v, bin);
-		timer.go("Sorting trace points");
-#if __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 3)
-		__gnu_parallel::sort(v.begin(), v.end());
-#else
-		merge_sort(v.begin(), v.end(), program_options::threads());
-#endif
+		thread *loader = bin+1 < trace_pts.bins() ? new thread(load_trace_pts<_locr,_locl>, &trace_pts, &v[(bin+1)%2], bin+1) : 0;
 		timer.go("Computing alignments");
-		align_queries<_val,_locr,_locl>(v, output_files);
+		align_queries<_val,_locr,_locl>(v[bin%2], output_files);
+		typename Trace_pt_buffer<_locr,_locl>::Vector().swap(v[bin%2]);
+		if(loader) {
+			timer.go("Waiting for trace points");
+			loader->join();
+			delete loader;
+		}
+		exception_state.sync();
 	}
 	//ref_bam_map.finish();
 }
@@ -62,7 +62,7 @@ void align_read(ptr_vector<Output_buffer<_val> > &buffers,
 	Map_t hits (begin, end);
 	typename Map_t::Iterator i = hits.begin();
 	while(i.valid()) {
-		align_sequence<_val,_locr,_locl>(*matches, stat, *local, padding, db_letters, source_query_len, i.begin(), i.end());
+		align_sequence<_val,_locr,_locl>(*matches, stat, *local, padding, db_letters, i.begin(), i.end());
 		++i;
 	}
 
@@ -82,6 +82,7 @@ void align_read(ptr_vector<Output_buffer<_val> > &buffers,
 			++it;
 			continue;
 		}
+		align_traceback(*it->traceback_, query_seqs<_val>::get()[query*contexts + it->frame_], it->frame_, source_query_len);
 		if(static_cast<double>(it->traceback_->identities_)*100/it->traceback_->len_ < program_options::min_id) {
 			++it;
 			continue;
@@ -28,13 +28,36 @@ Author: Benjamin Buchfink
 using boost::thread_specific_ptr;
 using std::vector;
 
+/* Alignments are first scored without traceback. The traceback is only computed
+   for the matches that are reported, by rerunning the extension from the seed. */
+
+template<typename _val>
+void align_traceback(local_match<_val> &l,
+		const sequence<const _val> &query,
+		unsigned frame,
+		unsigned dna_len)
+{
+	const unsigned query_pos = l.query_anchor_;
+	l = local_match<_val> (query_pos, l.subject_);
+	floating_sw(&query[query_pos],
+			l,
+			program_options::read_padding(query.length()),
+			score_matrix::get().rawscore(program_options::gapped_xdrop),
+			program_options::gap_open + program_options::gap_extend,
+			program_options::gap_extend,
+			Traceback ());
+	const Sequence_set<_val> &ref = ref_seqs<_val>::get();
+	anchored_transform(l, ref.local_position(ref.position(l.subject_)).second, query_pos);
+	if(query_translated())
+		to_dna_space(l, frame, dna_len);
+}
+
 template<typename _val, typename _locr, typename _locl>
 void align_sequence(vector<match<_val> > &matches,
 		Statistics &stat,
 		vector<local_match<_val> > &local,
 		unsigned *padding,
 		size_t db_letters,
-		unsigned dna_len,
 		typename Trace_pt_buffer<_locr,_locl>::Vector::iterator &begin,
 		typename Trace_pt_buffer<_locr,_locl>::Vector::iterator &end)
 {
@@ -52,21 +75,17 @@ void align_sequence(vector<match<_val> > &matches,
 			continue;
 		}
 		local.push_back(local_match<_val> (i->seed_offset_, ref->data(i->subject_)));
-		floating_sw(&query[i->seed_offset_],
-				local.back(),
+		const int score = floating_sw_score(&query[i->seed_offset_],
+				local.back().subject_,
 				padding[frame],
 				score_matrix::get().rawscore(program_options::gapped_xdrop),
 				program_options::gap_open + program_options::gap_extend,
-				program_options::gap_extend,
-				Traceback ());
-		const int score = local.back().score_;
+				program_options::gap_extend);
+		local.back().score_ = score;
 		std::pair<size_t,size_t> l = ref_seqs<_val>::data_->local_position(i->subject_);
 		matches.push_back(match<_val> (score, frame, score_matrix::get().evalue(score, db_letters, query_len), &local.back(), l.first));
 		matches.back().top_evalue_ = matches.back().evalue_;
-		anchored_transform(local.back(), l.second, i->seed_offset_);
-		if(query_translated())
-			to_dna_space(local.back(), frame, dna_len);
-		stat.inc(Statistics::SCORE_TOTAL, local.back().score_);
+		stat.inc(Statistics::SCORE_TOTAL, score);
 		stat.inc(Statistics::OUT_HITS);
 	}
 }
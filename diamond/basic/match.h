@@ -77,6 +77,56 @@ struct hit
 	{ return lhs.subject_ + rhs.seed_offset_ < rhs.subject_ + lhs.seed_offset_; }
 } __attribute__((packed));
 
+/* Trace points are spilled sorted by query and subject within each block. The
+   writer thread sorts the block and stores the query as a varint delta to the
+   previous record of the bin, the subject as a varint delta to the previous
+   subject of the same query (which may lie in the previous block) or as an
+   absolute varint for a new query, and the seed offset raw. Async_buffer
+   deflates each block on top of this. Subjects of one query are spread over
+   the whole reference, which bounds the gain to about 2x unless many hits of
+   a query share one block. */
+
+template<typename _locr, typename _locl>
+struct Spill_format<hit<_locr,_locl> >
+{
+	Spill_format():
+		query_ (0),
+		subject_ (0)
+	{ }
+	void encode(vector<hit<_locr,_locl> > &v, vector<char> &out)
+	{
+		std::sort(v.begin(), v.end(), cmp);
+		out.reserve(out.size() + v.size()*(4 + sizeof(_locl)));
+		for(typename vector<hit<_locr,_locl> >::const_iterator i=v.begin();i!=v.end();++i) {
+			const uint64_t subject = (uint64_t)i->subject_;
+			const _locl seed_offset = i->seed_offset_;
+			put_varint(out, zigzag((int64_t)i->query_ - (int64_t)query_));
+			put_varint(out, i->query_ == query_ ? zigzag((int64_t)(subject - subject_)) : subject);
+			out.insert(out.end(), reinterpret_cast<const char*>(&seed_offset), reinterpret_cast<const char*>(&seed_offset) + sizeof(_locl));
+			query_ = i->query_;
+			subject_ = subject;
+		}
+	}
+	const char* decode(const char *ptr, hit<_locr,_locl> *dst, size_t n)
+	{
+		for(size_t i=0;i<n;++i) {
+			const int64_t d = unzigzag(get_varint(ptr));
+			query_ = unsigned(int64_t(query_) + d);
+			subject_ = d == 0 ? subject_ + uint64_t(unzigzag(get_varint(ptr))) : get_varint(ptr);
+			_locl seed_offset;
+			memcpy(&seed_offset, ptr, sizeof(_locl));
+			ptr += sizeof(_locl);
+			dst[i] = hit<_locr,_locl> (query_, (_locr)subject_, seed_offset);
+		}
+		return ptr;
+	}
+private:
+	static bool cmp(const hit<_locr,_locl> &lhs, const hit<_locr,_locl> &rhs)
+	{ return lhs.query_ < rhs.query_ || (lhs.query_ == rhs.query_ && (uint64_t)lhs.subject_ < (uint64_t)rhs.subject_); }
+	unsigned query_;
+	uint64_t subject_;
+};
+
 template<typename _val>
 struct local_match
 {
@@ -148,8 +198,9 @@ struct local_match
 		add(rhs);
 		query_begin_ = rhs.query_len_;
 		subject_begin_ = rhs.subject_len_;
-		for(Edit_transcript::const_iterator i=rhs.transcript_->end()-2;i>=rhs.transcript_->begin();--i)
-			transcript_->push_back(*i);
+		if(rhs.transcript_)
+			for(Edit_transcript::const_iterator i=rhs.transcript_->end()-2;i>=rhs.transcript_->begin();--i)
+				transcript_->push_back(*i);
 		delete rhs.transcript_;
 		return *this;
 	}
@@ -75,6 +75,8 @@ string		seg;
 bool		verbose;
 bool		debug_log;
 bool		have_ssse3;
+bool		have_avx2;
+bool		have_avx512bw;
 bool		salltitles;
 int			reward;
 int			penalty;
@@ -82,6 +84,12 @@ string		db_type;
 double		min_id;
 unsigned	compress_temp;
 double		toppercent;
+bool		mmap_db;
+bool		seed_index;
+double		query_cache;
+double		prefetch_mem;
+unsigned	trace_pt_bins;
+double		bin_mem;
 
 Aligner_mode aligner_mode;
 Command command;
@@ -75,6 +75,8 @@ namespace program_options
 	extern bool		verbose;
 	extern bool		debug_log;
 	extern bool		have_ssse3;
+	extern bool		have_avx2;
+	extern bool		have_avx512bw;
 	extern bool		salltitles;
 	extern int		reward;
 	extern int		penalty;
@@ -82,6 +84,12 @@ namespace program_options
 	extern double	min_id;
 	extern unsigned	compress_temp;
 	extern double	toppercent;
+	extern bool		mmap_db;
+	extern bool		seed_index;
+	extern double	query_cache;
+	extern double	prefetch_mem;
+	extern unsigned	trace_pt_bins;
+	extern double	bin_mem;
 
 	typedef enum { fast=0, sensitive=1, very_sensitive=2 } Aligner_mode;
 	extern Aligner_mode aligner_mode;
@@ -109,6 +117,9 @@ namespace program_options
 	inline string database_file_name()
 	{ return database + ".dmnd"; }
 
+	inline string seed_index_file_name()
+	{ return database + ".sidx"; }
+
 	inline unsigned get_run_len(unsigned length)
 	{
 		if(run_len == 0) {
@@ -0,0 +1,134 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef SEED_ENUMERATOR_H_
+#define SEED_ENUMERATOR_H_
+
+#include <emmintrin.h>
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+#include "shape.h"
+
+/* Enumerates the seeds of a shape over a sequence from its reduced
+ * alphabet shadow, 16 consecutive positions at a time. The masked letter
+ * test is an OR over the shape positions, and the base 11 key is built by
+ * Horner's rule in 16 bit lanes for groups of 4 letters (11^4 < 2^16),
+ * which are combined into the 64 bit key only for valid positions. The
+ * fixed point seed frequency is summed in 16 bit lanes by table lookups
+ * (pshufb) on the low and high bytes of shape::freq_. The keys and the
+ * frequency decisions are the same as those of shape::set_seed. */
+
+struct Seed_enumerator
+{
+
+	enum { group_letters = 4, block = 16 };
+
+	Seed_enumerator(const shape &sh):
+		sh_ (sh),
+		groups_ ((sh.weight_ + group_letters - 1) / group_letters)
+	{
+		uint64_t scale = 1;
+		for(unsigned g=groups_;g>0;--g) {
+			scale_[g-1] = scale;
+			for(unsigned i=(g-1)*group_letters;i<std::min(g*group_letters,sh.weight_);++i)
+				scale *= 11;
+		}
+		for(unsigned r=0;r<16;++r) {
+			freq_lo_[r] = uint8_t(sh.freq_[r] & 0xFF);
+			freq_hi_[r] = uint8_t((sh.freq_[r] >> 8) & 0xFF);
+		}
+	}
+
+	/* Calls f(j, key) in order of j for every position j < n at which
+	 * the shape yields a seed. */
+	template<typename _f>
+	void enumerate(const uint8_t *reduced, unsigned n, _f &f) const
+	{
+		const __m128i letter_mask (_mm_set1_epi8(0x7F)), zero (_mm_setzero_si128()), eleven (_mm_set1_epi16(11));
+		uint16_t key[Const::max_seed_weight/group_letters][block];
+#ifdef __SSSE3__
+		const bool simd_freq = program_options::have_ssse3;
+		const __m128i freq_lo (_mm_loadu_si128((const __m128i*)freq_lo_)),
+			freq_hi (_mm_loadu_si128((const __m128i*)freq_hi_)),
+			accept (_mm_set1_epi16(sh_.accept_freq_)),
+			reject (_mm_set1_epi16(sh_.reject_freq_));
+		__m128i freq0, freq1;
+#endif
+		unsigned j = 0;
+		for(;j+block<=n;j+=block) {
+			__m128i masked (zero);
+#ifdef __SSSE3__
+			freq0 = zero;
+			freq1 = zero;
+#endif
+			for(unsigned g=0;g<groups_;++g) {
+				__m128i lo (zero), hi (zero);
+				for(unsigned i=g*group_letters;i<std::min((g+1)*group_letters,sh_.weight_);++i) {
+					const __m128i r (_mm_loadu_si128((const __m128i*)(reduced + j + sh_.positions_[i])));
+					masked = _mm_or_si128(masked, r);
+#ifdef __SSSE3__
+					if(simd_freq) {
+						const __m128i fl (_mm_shuffle_epi8(freq_lo, r)), fh (_mm_shuffle_epi8(freq_hi, r));
+						freq0 = _mm_add_epi16(freq0, _mm_unpacklo_epi8(fl, fh));
+						freq1 = _mm_add_epi16(freq1, _mm_unpackhi_epi8(fl, fh));
+					}
+#endif
+					const __m128i l (_mm_and_si128(r, letter_mask));
+					lo = _mm_add_epi16(_mm_mullo_epi16(lo, eleven), _mm_unpacklo_epi8(l, zero));
+					hi = _mm_add_epi16(_mm_mullo_epi16(hi, eleven), _mm_unpackhi_epi8(l, zero));
+				}
+				_mm_storeu_si128((__m128i*)key[g], lo);
+				_mm_storeu_si128((__m128i*)(key[g]+8), hi);
+			}
+			unsigned valid = ~_mm_movemask_epi8(masked) & 0xFFFF, uncertain = valid;
+#ifdef __SSSE3__
+			if(simd_freq) {
+				valid &= _mm_movemask_epi8(_mm_packs_epi16(_mm_cmplt_epi16(freq0, reject), _mm_cmplt_epi16(freq1, reject)));
+				uncertain = valid & _mm_movemask_epi8(_mm_packs_epi16(_mm_cmpgt_epi16(freq0, accept), _mm_cmpgt_epi16(freq1, accept)));
+			}
+#endif
+			while(valid) {
+				const unsigned l = __builtin_ctz(valid);
+				valid &= valid - 1;
+				if(((uncertain >> l) & 1) && !sh_.is_low_freq(reduced + j + l))
+					continue;
+				uint64_t s = 0;
+				for(unsigned g=0;g<groups_;++g)
+					s += key[g][l] * scale_[g];
+				f(j + l, s);
+			}
+		}
+		uint64_t s;
+		for(;j<n;++j)
+			if(sh_.set_seed(s, reduced + j))
+				f(j, s);
+	}
+
+private:
+
+	const shape &sh_;
+	const unsigned groups_;
+	uint64_t scale_[Const::max_seed_weight/group_letters];
+	uint8_t freq_lo_[16], freq_hi_[16];
+
+};
+
+#endif /* SEED_ENUMERATOR_H_ */
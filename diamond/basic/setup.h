@@ -107,6 +107,12 @@ void setup(const string &command, int ac, const char **av)
 	po::have_ssse3 = check_SSSE3();
 	if(po::have_ssse3)
 		verbose_stream << "SSSE3 enabled." << endl;
+	po::have_avx2 = check_AVX2();
+	if(po::have_avx2)
+		verbose_stream << "AVX2 enabled." << endl;
+	po::have_avx512bw = check_AVX512BW();
+	if(po::have_avx512bw)
+		verbose_stream << "AVX-512BW enabled." << endl;
 	if(po::debug_log) {
 		copy_file(log_stream, "/etc/issue");
 		copy_file(log_stream, "/proc/cpuinfo");
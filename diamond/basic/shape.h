@@ -21,6 +21,8 @@ Author: Benjamin Buchfink
 #ifndef SHAPE_H_
 #define SHAPE_H_
 
+#include <cmath>
+#include <algorithm>
 #include "const.h"
 #include "value.h"
 #include "seed.h"
@@ -49,8 +51,13 @@ struct shape
 		d_ (0),
 		mask_ (0),
 		rev_mask_ (0),
-		id_ (0)
-	{ memset(positions_, 0, sizeof(uint32_t)*Const::max_seed_weight); }
+		id_ (0),
+		accept_freq_ (0),
+		reject_freq_ (0)
+	{
+		memset(positions_, 0, sizeof(uint32_t)*Const::max_seed_weight);
+		memset(freq_, 0, sizeof(freq_));
+	}
 
 	shape(const char *code, unsigned id):
 		weight_ (0),
@@ -74,6 +81,7 @@ struct shape
 		}
 		length_ = i;
 		d_ = positions_[weight_/2-1];
+		init_freq();
 	}
 
 	template<typename _val>
@@ -95,6 +103,21 @@ struct shape
 		return true;
 	}
 
+	inline bool set_seed(uint64_t &s, const uint8_t *reduced) const
+	{
+		s = 0;
+		int f = 0;
+		for(unsigned i=0;i<weight_;++i) {
+			const unsigned r = reduced[positions_[i]];
+			if(r & 0x80)
+				return false;
+			f += freq_[r];
+			s *= 11;
+			s += uint64_t(r);
+		}
+		return low_freq(f, reduced);
+	}
+
 	template<typename _val>
 	inline bool	is_low_freq(const _val *seq) const
 	{
@@ -110,6 +133,37 @@ struct shape
 		return f <= program_options::max_seed_freq;
 	}
 
+	inline bool	is_low_freq(const uint8_t *reduced) const
+	{
+		int f = 0;
+		for(unsigned i=0;i<weight_;++i) {
+			const unsigned r = reduced[positions_[i]];
+			if(r & 0x80)
+				return false;
+			f += freq_[r];
+		}
+		return low_freq(f, reduced);
+	}
+
+	/* Decides a seed from its fixed point frequency f, falling back to
+	 * the double sum only inside the rounding band around the threshold. */
+	inline bool low_freq(int f, const uint8_t *reduced) const
+	{
+		if(f <= accept_freq_)
+			return true;
+		if(f >= reject_freq_)
+			return false;
+		return exact_freq(reduced) <= program_options::max_seed_freq;
+	}
+
+	inline double exact_freq(const uint8_t *reduced) const
+	{
+		double f = 0;
+		for(unsigned i=0;i<weight_;++i)
+			f += background_freq[reduced[positions_[i]]];
+		return f;
+	}
+
 	template<typename _val>
 	inline bool	is_low_freq_rev(const _val *seq) const
 	{
@@ -126,6 +180,30 @@ struct shape
 	}
 
 	uint32_t length_, weight_, positions_[Const::max_seed_weight], d_, mask_, rev_mask_, id_;
+	int16_t freq_[16], accept_freq_, reject_freq_;
+
+private:
+
+	/* Fixed point copy of background_freq scaled so that the frequency of
+	 * a seed fits 16 bits. Each table entry is off by at most 1/2, so the
+	 * scaled double sum lies within weight/2 of the integer sum; seeds
+	 * beyond that band (plus a margin of 1 for the double's own rounding)
+	 * are decided by the integer sum alone. Clamping the bounds to 16 bits
+	 * keeps the decisions exact, since no integer sum leaves that range. */
+	void init_freq()
+	{
+		const unsigned n = sizeof(background_freq)/sizeof(background_freq[0]);
+		double m = 0;
+		for(unsigned r=0;r<n;++r)
+			m = std::max(m, -background_freq[r]);
+		const double scale = std::floor((32767.0/weight_ - 0.5) / m);
+		memset(freq_, 0, sizeof(freq_));
+		for(unsigned r=0;r<n;++r)
+			freq_[r] = (int16_t)std::floor(background_freq[r]*scale + 0.5);
+		const double t = program_options::max_seed_freq * scale, band = weight_*0.5 + 1;
+		accept_freq_ = (int16_t)std::max(std::min(std::floor(t - band), 32767.0), -32768.0);
+		reject_freq_ = (int16_t)std::max(std::min(std::ceil(t + band), 32767.0), -32768.0);
+	}
 
 };
 
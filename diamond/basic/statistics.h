@@ -27,7 +27,7 @@ struct Statistics
 {
 
 	enum value { SEED_HITS, TENTATIVE_MATCHES0, TENTATIVE_MATCHES1, TENTATIVE_MATCHES2, TENTATIVE_MATCHES3, MATCHES, ALIGNED, GAPPED, DUPLICATES,
-		GAPPED_HITS, QUERY_SEEDS, QUERY_SEEDS_HIT, REF_SEEDS, REF_SEEDS_HIT, QUERY_SIZE, REF_SIZE, OUT_HITS, OUT_MATCHES, COLLISION_LOOKUPS, QCOV, BIAS_ERRORS, SCORE_TOTAL, COUNT };
+		GAPPED_HITS, QUERY_SEEDS, QUERY_SEEDS_HIT, REF_SEEDS, REF_SEEDS_HIT, QUERY_SIZE, REF_SIZE, OUT_HITS, OUT_MATCHES, COLLISION_LOOKUPS, QCOV, BIAS_ERRORS, SCORE_TOTAL, SW_OVERFLOW, SW_OVERFLOW16, COUNT };
 
 	Statistics()
 	{ memset(data_, 0, sizeof(data_)); }
@@ -50,6 +50,8 @@ struct Statistics
 		log_stream << "Tentative hits (stage 2) = " << data_[TENTATIVE_MATCHES2] << endl;
 		log_stream << "Tentative hits (stage 3) = " << data_[TENTATIVE_MATCHES3] << endl;
 		log_stream << "Gapped hits = " << data_[GAPPED_HITS] << endl;
+		log_stream << "Saturated hit scores = " << data_[SW_OVERFLOW] << endl;
+		log_stream << "Saturated 16 bit hit scores = " << data_[SW_OVERFLOW16] << endl;
 		log_stream << "Overlap hits = " << data_[DUPLICATES] << endl;
 		log_stream << "Net hits = " << data_[OUT_HITS] << endl;
 		log_stream << "Matches = " << data_[OUT_MATCHES] << endl;
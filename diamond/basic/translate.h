@@ -21,6 +21,11 @@ Author: Benjamin Buchfink
 #ifndef TRANSLATE_H_
 #define TRANSLATE_H_
 
+#include <emmintrin.h>
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
 struct Translator
 {
 
@@ -192,4 +197,177 @@ const Amino_acid Translator::lookupReverse[5][5][5] = {
 
 const Amino_acid Translator::STOP (Value_traits<Amino_acid>::from_char('*'));
 
+/* Translates the six reading frames of a sequence straight into their
+ * destination, giving the same letters as Translator::translate. Codons
+ * of 16 consecutive positions are looked up at once (pshufb on 16 entry
+ * tables selected by the first letter, with the N cases patched in), and
+ * every third codon is picked for each frame by shuffles. The reverse
+ * frames are read the same way from the reversed sequence. The stop free
+ * runs used by Translator::computeGoodFrames are tracked in the same
+ * pass. */
+
+struct Frame_translator
+{
+
+	/* Writes frames f and f+3, of (len-f)/3 letters each, to frames[f] and
+	 * frames[f+3], and returns the set of frames holding a stop free run of
+	 * at least run_len letters. */
+	unsigned operator()(const Nucleotide *seq, size_t len, Amino_acid *const *frames, unsigned run_len)
+	{
+		if(len < 3)
+			return 0;
+		const size_t n = len - 2;
+		if(aa_.size() < n)
+			aa_.resize(n);
+		if(rev_.size() < len)
+			rev_.resize(len);
+		codons(seq, n, tables_.forward, Translator::lookup, aa_.data());
+		const unsigned good = split(aa_.data(), len, frames, run_len);
+		reverse(seq, len, rev_.data());
+		codons(rev_.data(), n, tables_.reverse, Translator::lookupReverse, aa_.data());
+		// Translator::translate reads the last codon of frame 4 from the position of frame 3.
+		if(len % 3 == 1)
+			aa_[n-1] = aa_[n-2];
+		return good | (split(aa_.data(), len, frames + 3, run_len) << 3);
+	}
+
+private:
+
+	struct Tables
+	{
+		Tables()
+		{
+			build(Translator::lookup, forward);
+			build(Translator::lookupReverse, reverse);
+			for(unsigned f=0;f<3;++f)
+				for(unsigned k=0;k<3;++k)
+					for(unsigned j=0;j<16;++j) {
+						const int i = 3*j + f - 16*k;
+						frame[f][k][j] = i >= 0 && i < 16 ? i : 0x80;
+					}
+		}
+		/* Rows 0-3 map 4*b+c to the codon (a,b,c) with first letter a, row 4
+		 * maps 4*a+b to the codon (a,b,N). */
+		static void build(const Amino_acid (&table)[5][5][5], uint8_t (&t)[5][16])
+		{
+			for(unsigned a=0;a<4;++a)
+				for(unsigned b=0;b<4;++b) {
+					for(unsigned c=0;c<4;++c)
+						t[a][4*b+c] = (char)table[a][b][c];
+					t[4][4*a+b] = (char)table[a][b][4];
+				}
+		}
+		uint8_t forward[5][16], reverse[5][16], frame[3][3][16];
+	};
+
+	struct Stop_runs
+	{
+		Stop_runs():
+			last (-1),
+			max (0)
+		{ }
+		void stop(long i)
+		{
+			max = std::max(max, i - last - 1);
+			last = i;
+		}
+		void stops(unsigned mask, long base)
+		{
+			while(mask) {
+				stop(base + __builtin_ctz(mask));
+				mask &= mask - 1;
+			}
+		}
+		bool good(long len, unsigned run_len) const
+		{ return std::max(max, len - last - 1) >= (long)run_len; }
+		long last, max;
+	};
+
+	static void codons(const Nucleotide *s, size_t n, const uint8_t (&t)[5][16], const Amino_acid (&table)[5][5][5], Amino_acid *dst)
+	{
+		size_t p = 0;
+#ifdef __SSSE3__
+		if(program_options::have_ssse3) {
+			const __m128i four (_mm_set1_epi8(4)), high (_mm_set1_epi8((char)0x80)), mask (_mm_set1_epi8(char(Value_traits<Amino_acid>::MASK_CHAR)));
+			__m128i row[5];
+			for(unsigned k=0;k<5;++k)
+				row[k] = _mm_loadu_si128((const __m128i*)t[k]);
+			for(;p+16<=n;p+=16) {
+				const __m128i a (_mm_loadu_si128((const __m128i*)(s+p))),
+					b (_mm_loadu_si128((const __m128i*)(s+p+1))),
+					c (_mm_loadu_si128((const __m128i*)(s+p+2))),
+					bc (_mm_or_si128(_mm_slli_epi16(b, 2), c));
+				__m128i r (_mm_setzero_si128());
+				for(unsigned k=0;k<4;++k)
+					r = _mm_or_si128(r, _mm_shuffle_epi8(row[k], _mm_or_si128(bc, _mm_andnot_si128(_mm_cmpeq_epi8(a, _mm_set1_epi8(k)), high))));
+				const __m128i n_ab (_mm_or_si128(_mm_cmpeq_epi8(a, four), _mm_cmpeq_epi8(b, four))),
+					n_c (_mm_andnot_si128(n_ab, _mm_cmpeq_epi8(c, four))),
+					r_c (_mm_shuffle_epi8(row[4], _mm_or_si128(_mm_slli_epi16(a, 2), b)));
+				r = _mm_or_si128(_mm_andnot_si128(n_c, r), _mm_and_si128(n_c, r_c));
+				r = _mm_or_si128(_mm_andnot_si128(n_ab, r), _mm_and_si128(n_ab, mask));
+				_mm_storeu_si128((__m128i*)(dst+p), r);
+			}
+		}
+#endif
+		for(;p<n;++p)
+			dst[p] = table[(int)s[p]][(int)s[p+1]][(int)s[p+2]];
+	}
+
+	static void reverse(const Nucleotide *s, size_t len, Nucleotide *dst)
+	{
+		size_t i = 0;
+#ifdef __SSSE3__
+		if(program_options::have_ssse3) {
+			const __m128i r (_mm_set_epi8(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15));
+			for(;i+16<=len;i+=16)
+				_mm_storeu_si128((__m128i*)(dst+i), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(s+len-i-16)), r));
+		}
+#endif
+		for(;i<len;++i)
+			dst[i] = s[len-1-i];
+	}
+
+	/* Frame f takes the codons f, f+3, ... of the len-2 codons in aa. */
+	static unsigned split(const Amino_acid *aa, size_t len, Amino_acid *const *frames, unsigned run_len)
+	{
+		Stop_runs runs[3];
+		size_t i = 0;
+#ifdef __SSSE3__
+		if(program_options::have_ssse3) {
+			const size_t n = len - 2;
+			const __m128i stop (_mm_set1_epi8(char(Translator::STOP)));
+			for(;3*i+48<=n;i+=16) {
+				const __m128i a (_mm_loadu_si128((const __m128i*)(aa+3*i))),
+					b (_mm_loadu_si128((const __m128i*)(aa+3*i+16))),
+					c (_mm_loadu_si128((const __m128i*)(aa+3*i+32)));
+				for(unsigned f=0;f<3;++f) {
+					const __m128i v (_mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, _mm_loadu_si128((const __m128i*)tables_.frame[f][0])),
+							_mm_shuffle_epi8(b, _mm_loadu_si128((const __m128i*)tables_.frame[f][1]))),
+							_mm_shuffle_epi8(c, _mm_loadu_si128((const __m128i*)tables_.frame[f][2]))));
+					_mm_storeu_si128((__m128i*)(frames[f]+i), v);
+					runs[f].stops(_mm_movemask_epi8(_mm_cmpeq_epi8(v, stop)), i);
+				}
+			}
+		}
+#endif
+		unsigned good = 0;
+		for(unsigned f=0;f<3;++f) {
+			const size_t l = (len - f) / 3;
+			for(size_t j=i;j<l;++j)
+				if((frames[f][j] = aa[f+3*j]) == Translator::STOP)
+					runs[f].stop(j);
+			if(runs[f].good(l, run_len))
+				good |= 1 << f;
+		}
+		return good;
+	}
+
+	static const Tables tables_;
+	vector<Nucleotide> rev_;
+	vector<Amino_acid> aa_;
+
+};
+
+const Frame_translator::Tables Frame_translator::tables_;
+
 #endif /* TRANSLATE_H_ */
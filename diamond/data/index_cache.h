@@ -0,0 +1,141 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef INDEX_CACHE_H_
+#define INDEX_CACHE_H_
+
+#include <string>
+#include <vector>
+#include "sorted_list.h"
+#include "../util/binary_file.h"
+
+using std::string;
+using std::vector;
+
+/* Keeps the query seed lists of one query chunk for reuse with all reference blocks.
+   Lists are held in memory up to max_size bytes and written to a temporary file beyond that. */
+
+template<typename _pos>
+struct Index_cache
+{
+
+	typedef typename sorted_list<_pos>::Type List;
+	typedef typename List::entry Entry;
+
+	Index_cache(bool enabled, unsigned shapes, unsigned chunks, size_t max_size, const string &tmpdir):
+		enabled_ (enabled),
+		chunks_ (chunks),
+		max_size_ (max_size),
+		mem_size_ (0),
+		file_size_ (0),
+		file_name_ (tmpdir + "/diamond_" + boost::to_string(program_options::magic_number) + "_query_index.tmp"),
+		items_ (shapes*chunks),
+		out_ (0),
+		in_ (0)
+	{ }
+
+	~Index_cache()
+	{
+		for(typename vector<Item>::iterator i = items_.begin(); i != items_.end(); ++i)
+			delete[] i->data;
+		delete out_;
+		delete in_;
+		if(file_size_ > 0)
+			::remove(file_name_.c_str());
+		if(enabled_)
+			log_stream << "Query index cache: " << mem_size_ << " bytes in memory, " << file_size_ << " bytes on disk" << endl;
+	}
+
+	bool contains(unsigned sid, unsigned chunk) const
+	{ return item(sid, chunk).present; }
+
+	Entry* get(unsigned sid, unsigned chunk, char *buffer)
+	{
+		const Item &i = item(sid, chunk);
+		if(i.data != 0)
+			return reinterpret_cast<Entry*>(i.data);
+		if(in_ == 0) {
+			out_->close();
+			delete out_;
+			out_ = 0;
+			in_ = new Input_stream (file_name_);
+		}
+		in_->seekg(i.offset);
+		if(in_->read(buffer, i.size) != i.size)
+			THROW_EXCEPTION(file_io_exception, file_name_);
+		return reinterpret_cast<Entry*>(buffer);
+	}
+
+	void put(unsigned sid, unsigned chunk, const List &list)
+	{
+		Item &i = item(sid, chunk);
+		if(!enabled_ || i.present)
+			return;
+		i.size = list.size() * sizeof(Entry);
+		if(mem_size_ + i.size <= max_size_) {
+			i.data = new char[i.size];
+			memcpy(i.data, list.data(), i.size);
+			mem_size_ += i.size;
+		} else {
+			if(out_ == 0)
+				out_ = new Output_stream (file_name_);
+			out_->write(reinterpret_cast<const char*>(list.data()), i.size);
+			i.offset = file_size_;
+			file_size_ += i.size;
+		}
+		i.present = true;
+	}
+
+private:
+
+	struct Item
+	{
+		Item():
+			present (false),
+			data (0),
+			offset (0),
+			size (0)
+		{ }
+		bool present;
+		char *data;
+		size_t offset, size;
+	};
+
+	Item& item(unsigned sid, unsigned chunk)
+	{ return items_[sid*chunks_ + chunk]; }
+
+	const Item& item(unsigned sid, unsigned chunk) const
+	{ return items_[sid*chunks_ + chunk]; }
+
+	Index_cache(const Index_cache&);
+	Index_cache& operator=(const Index_cache&);
+
+	const bool enabled_;
+	const unsigned chunks_;
+	const size_t max_size_;
+	size_t mem_size_, file_size_;
+	const string file_name_;
+	vector<Item> items_;
+	Output_stream *out_;
+	Input_stream *in_;
+
+};
+
+#endif /* INDEX_CACHE_H_ */
@@ -26,58 +26,115 @@ Author: Benjamin Buchfink
 #include "../util/complexity_filter.h"
 #include "../util/seq_file_format.h"
 
+/* Converts an input record into its strings of the sequence set: one for
+ * plain sequences, six reading frames for translated ones. */
+
 template<typename _ival, typename _val>
-size_t push_seq(String_set<_val> &ss, const vector<_ival> &seq)
-{ ss.push_back(seq); return seq.size(); }
+struct Seq_converter
+{
+	enum { contexts = 1 };
+	static size_t length(size_t len, unsigned context)
+	{ return len; }
+	void operator()(const Seq_record &r, Sequence_set<_val> &ss, size_t i)
+	{ decode_seq(r.seq_begin, r.seq_end, ss.ptr(i)); }
+};
 
 template<>
-size_t push_seq<Nucleotide,Amino_acid>(String_set<Amino_acid> &ss, const vector<Nucleotide> &seq)
+struct Seq_converter<Nucleotide,Amino_acid>
 {
-	if(seq.size() < 2) {
+	enum { contexts = 6 };
+	static size_t length(size_t len, unsigned context)
+	{ return len < 2 ? 0 : (len - context%3) / 3; }
+	void operator()(const Seq_record &r, Sequence_set<Amino_acid> &ss, size_t i)
+	{
+		seq_.resize(r.length);
+		decode_seq(r.seq_begin, r.seq_end, seq_.data());
+		if(r.length < 2)
+			return;
+		Amino_acid *frames[6];
 		for(unsigned j=0;j<6;++j)
-			ss.fill(0, Value_traits<Amino_acid>::MASK_CHAR);
-		return 0;
+			frames[j] = ss.ptr(i+j);
+		const unsigned bestFrames (translate_(seq_.data(), r.length, frames, program_options::get_run_len(r.length/3)));
+		for(unsigned j = 0; j < 6; ++j)
+			if(!(bestFrames & (1 << j)))
+				std::fill(frames[j], frames[j] + length(r.length, j), Value_traits<Amino_acid>::MASK_CHAR);
 	}
-	vector<Amino_acid> proteins[6];
-	size_t length_ = seq.size(), d, n;
-	proteins[0].resize(d = length_ / 3);
-	proteins[3].resize(d);
-	n = 2*d;
-	proteins[1].resize(d = (length_-1) / 3);
-	proteins[4].resize(d);
-	n += 2*d;
-	proteins[2].resize(d = (length_-2) / 3);
-	proteins[5].resize(d);
-	n += 2*d;
+private:
+	vector<Nucleotide> seq_;
+	Frame_translator translate_;
+};
 
-	Translator::translate(seq, proteins);
+/* Appends the records to the sets and converts them in parallel. An
+ * invalid record is converted again afterwards to throw its exception
+ * from the calling thread. */
+template<typename _ival, typename _val>
+void store_seqs(const vector<Seq_record> &records,
+		Sequence_set<_val> &seqs,
+		String_set<char,0> &ids,
+		size_t id_letters,
+		size_t letters)
+{
+	typedef Seq_converter<_ival,_val> Converter;
+	const size_t n (records.size()), first_id (ids.get_length()), first_seq (seqs.get_length());
+	ids.reserve(n, id_letters);
+	seqs.reserve(n*Converter::contexts, letters);
+	for(size_t i=0;i<n;++i) {
+		ids.push_back(records[i].id_end - records[i].id_begin);
+		for(unsigned j=0;j<Converter::contexts;++j)
+			seqs.push_back(Converter::length(records[i].length, j));
+	}
 
-	unsigned bestFrames (Translator::computeGoodFrames(proteins, program_options::get_run_len(length_/3)));
-	for(unsigned j = 0; j < 6; ++j) {
-		if(bestFrames & (1 << j))
-			ss.push_back(proteins[j]);
-		else
-			ss.fill(proteins[j].size(), Value_traits<Amino_acid>::MASK_CHAR);
+	long failed = (long)n;
+#pragma omp parallel
+	{
+		Converter convert;
+#pragma omp for schedule(dynamic, 256)
+		for(long i=0;i<(long)n;++i) {
+			const Seq_record &r = records[i];
+			memcpy(ids.ptr(first_id + i), r.id_begin, r.id_end - r.id_begin);
+			try {
+				convert(r, seqs, first_seq + i*Converter::contexts);
+			} catch(std::exception&) {
+#pragma omp critical
+				failed = std::min(failed, i);
+			}
+		}
 	}
-	return n;
+	if(failed < (long)n)
+		Converter () (records[failed], seqs, first_seq + failed*Converter::contexts);
 }
 
 template<typename _ival, typename _val>
-size_t load_seqs(Input_stream &file,
+size_t load_seqs(Input_buffer &file,
 		const Sequence_file_format<_ival> &format,
 		Sequence_set<_val>*& seqs,
 		String_set<char,0>*& ids,
 		size_t max_letters)
 {
+	typedef Seq_converter<_ival,_val> Converter;
 	seqs = new Sequence_set<_val> ();
 	ids = new String_set<char,0> ();
 	size_t letters = 0, n = 0;
-	vector<_ival> seq;
-	vector<char> id;
-	while(letters < max_letters && format.get_seq(id, seq, file)) {
-		ids->push_back(id);
-		letters += push_seq<_ival,_val>(*seqs, seq);
-		++n;
+	vector<Seq_record> records;
+	for(;;) {
+		const char *p = file.begin(), *q;
+		size_t id_letters = 0, block_letters = 0;
+		Seq_record r;
+		records.clear();
+		while(letters + block_letters < max_letters && (q = format.get_record(p, file.end(), file.eof(), r)) != 0) {
+			records.push_back(r);
+			id_letters += r.id_end - r.id_begin;
+			for(unsigned j=0;j<Converter::contexts;++j)
+				block_letters += Converter::length(r.length, j);
+			p = q;
+		}
+		store_seqs<_ival,_val>(records, *seqs, *ids, id_letters, block_letters);
+		file.consume(p);
+		letters += block_letters;
+		n += records.size();
+		if(letters >= max_letters || file.eof())
+			break;
+		file.fetch();
 	}
 	ids->finish_reserve();
 	seqs->finish_reserve();
@@ -0,0 +1,61 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef PREFETCH_BUDGET_H_
+#define PREFETCH_BUDGET_H_
+
+#include "../basic/options.h"
+
+/* The memory set by --prefetch-mem, shared by the reference and the query
+   prefetching. Each loader holds one reservation for its current and its
+   prefetched data and gives it back when the prefetched data becomes current.
+   Only called from the master thread. */
+
+struct Prefetch_budget
+{
+
+	Prefetch_budget():
+		used_ (0)
+	{ }
+
+	/* Replaces the reservation in slot by bytes. Returns false and leaves slot
+	   unchanged if the total would exceed the limit. */
+	bool reserve(size_t &slot, size_t bytes)
+	{
+		if(program_options::prefetch_mem > 0 && used_ - slot + bytes > (size_t)(program_options::prefetch_mem * 1e9))
+			return false;
+		used_ += bytes - slot;
+		slot = bytes;
+		return true;
+	}
+
+	void release(size_t &slot)
+	{
+		used_ -= slot;
+		slot = 0;
+	}
+
+private:
+
+	size_t used_;
+
+} prefetch_budget;
+
+#endif /* PREFETCH_BUDGET_H_ */
@@ -21,11 +21,16 @@ Author: Benjamin Buchfink
 #ifndef QUERIES_H_
 #define QUERIES_H_
 
+#include <omp.h>
 #include "../basic/translate.h"
 #include "../util/complexity_filter.h"
 #include "sorted_list.h"
 #include "../basic/statistics.h"
 #include "sequence_set.h"
+#include "seed_histogram.h"
+#include "load_seqs.h"
+#include "reference.h"
+#include "prefetch_budget.h"
 
 auto_ptr<seed_histogram> query_hst;
 unsigned current_query_chunk;
@@ -49,4 +54,123 @@ struct query_ids
 
 String_set<char,0>* query_ids::data_ = 0;
 
+/* Loads the query chunks in order, running the complexity filter and
+   building the seed histograms. While one chunk is searched, the next one
+   can be prepared by a background thread as long as both fit into
+   --prefetch-mem, together with the seed index of the current chunk. The
+   search keeps all threads busy meanwhile, so the background thread loads
+   with a single OpenMP thread and gzip worker. */
+
+template<typename _val>
+struct Query_loader
+{
+
+	Query_loader(Input_buffer &file,
+			const Sequence_file_format<Nucleotide> &format_n,
+			const Sequence_file_format<Amino_acid> &format_a):
+		file_ (file),
+		format_n_ (format_n),
+		format_a_ (format_a),
+		seqs_ (0),
+		ids_ (0),
+		hst_ (0),
+		n_ (0),
+		thread_ (0),
+		reserved_ (0)
+	{ }
+
+	~Query_loader()
+	{
+		join();
+		prefetch_budget.release(reserved_);
+		delete seqs_;
+		delete ids_;
+		delete hst_;
+	}
+
+	/* Makes the next chunk current and returns its number of sequences. */
+	size_t next()
+	{
+		if(thread_ != 0)
+			join();
+		else
+			read(this, false);
+		prefetch_budget.release(reserved_);
+		exception_state.sync();
+		const size_t n = n_;
+		if(n > 0) {
+			query_seqs<_val>::data_ = seqs_;
+			query_ids::data_ = ids_;
+			query_hst = auto_ptr<seed_histogram> (hst_);
+			seqs_ = 0;
+			ids_ = 0;
+			hst_ = 0;
+		}
+		n_ = 0;
+		return n;
+	}
+
+	bool prefetch()
+	{
+		typedef sorted_list<uint64_t>::Type::entry Entry;
+		const size_t chunk_size = query_seqs<_val>::get().raw_len()*(sizeof(_val) + 1)
+				+ query_ids::get().raw_len()
+				+ sizeof(seed_histogram);
+		const size_t index_size = query_hst->max_chunk_size() * sizeof(Entry)
+				+ (ref_header.n_blocks > 1 ? std::min(query_seqs<_val>::get().letters() * shape_config::get().count() * sizeof(Entry),
+						(size_t)((program_options::query_cache == 0 ? program_options::chunk_size : program_options::query_cache) * 1e9)) : 0);
+		if(!prefetch_budget.reserve(reserved_, 2*chunk_size + index_size))
+			return false;
+		thread_ = new thread(read, this, true);
+		return true;
+	}
+
+private:
+
+	static void read(Query_loader *me, bool background)
+	{
+		try {
+			if(background)
+				omp_set_num_threads(1);
+			me->file_.set_threads(background ? 1 : program_options::threads() - 1);
+			const size_t max_letters = (size_t)(program_options::chunk_size * 1e9);
+			if(input_sequence_type() == nucleotide)
+				me->n_ = load_seqs<Nucleotide,_val>(me->file_, me->format_n_, me->seqs_, me->ids_, max_letters);
+			else
+				me->n_ = load_seqs<Amino_acid,_val>(me->file_, me->format_a_, me->seqs_, me->ids_, max_letters);
+			if(me->n_ == 0) {
+				me->seqs_ = 0;
+				me->ids_ = 0;
+				return;
+			}
+			if(program_options::seg == "yes")
+				Complexity_filter<_val>::get().run(*me->seqs_);
+			me->seqs_->build_reduced();
+			me->hst_ = new seed_histogram (*me->seqs_, _val());
+		} catch(std::exception &e) {
+			exception_state.set(e);
+		}
+	}
+
+	void join()
+	{
+		if(thread_ == 0)
+			return;
+		thread_->join();
+		delete thread_;
+		thread_ = 0;
+	}
+
+	Input_buffer &file_;
+	const Sequence_file_format<Nucleotide> &format_n_;
+	const Sequence_file_format<Amino_acid> &format_a_;
+	Sequence_set<_val> *seqs_;
+	String_set<char,0> *ids_;
+	seed_histogram *hst_;
+	size_t n_;
+	thread *thread_;
+	size_t reserved_;
+
+};
+
 #endif /* QUERIES_H_ */
@@ -28,10 +28,11 @@ Author: Benjamin Buchfink
 #include "sorted_list.h"
 #include "../basic/statistics.h"
 #include "../data/seed_histogram.h"
-#include "../util/hash_table.h"
+#include "../util/filter_table.h"
 #include "../util/hash_function.h"
 #include "../basic/packed_loc.h"
 #include "sequence_set.h"
+#include "prefetch_budget.h"
 #include "boost/ptr_container/ptr_vector.hpp"
 
 using std::auto_ptr;
@@ -63,7 +64,8 @@ struct Database_format_exception : public exception
 struct Database_file : public Input_stream
 {
 	Database_file():
-		Input_stream (program_options::database_file_name())
+		Input_stream (program_options::database_file_name()),
+		map_ (program_options::mmap_db ? new Mapped_file (program_options::database_file_name()) : 0)
 	{
 		if(this->read(&ref_header, 1) != 1)
 			throw Database_format_exception ();
@@ -74,6 +76,17 @@ struct Database_file : public Input_stream
 	}
 	void rewind()
 	{ this->seekg(sizeof(Reference_header)); }
+	template<typename _val>
+	Sequence_set<_val>* load_seqs()
+	{
+		Sequence_set<_val> *seqs (map_.get() ? new Sequence_set<_val> (*this, *map_) : new Sequence_set<_val> (*this));
+		seqs->build_reduced();
+		return seqs;
+	}
+	String_set<char,0>* load_ids()
+	{ return map_.get() ? new String_set<char,0> (*this, *map_) : new String_set<char,0> (*this); }
+private:
+	const auto_ptr<Mapped_file> map_;
 };
 
 template<typename _val>
@@ -95,7 +108,93 @@ struct ref_ids
 
 String_set<char,0>* ref_ids::data_ = 0;
 
-seed_histogram ref_hst;
+auto_ptr<seed_histogram> ref_hst;
+
+/* Loads the reference blocks in order. While one block is searched, the next one
+   can be read by a background thread as long as both fit into the part of
+   --prefetch-mem not taken by the query chunks. */
+
+template<typename _val>
+struct Reference_loader
+{
+
+	Reference_loader(Database_file &db_file):
+		db_file_ (db_file),
+		seqs_ (0),
+		ids_ (0),
+		hst_ (0),
+		thread_ (0),
+		reserved_ (0)
+	{ }
+
+	~Reference_loader()
+	{
+		join();
+		prefetch_budget.release(reserved_);
+		delete seqs_;
+		delete ids_;
+		delete hst_;
+	}
+
+	void next()
+	{
+		if(thread_ != 0)
+			join();
+		else
+			read(this);
+		prefetch_budget.release(reserved_);
+		exception_state.sync();
+		ref_seqs<_val>::data_ = seqs_;
+		ref_ids::data_ = ids_;
+		ref_hst = auto_ptr<seed_histogram> (hst_);
+		seqs_ = 0;
+		ids_ = 0;
+		hst_ = 0;
+	}
+
+	bool prefetch()
+	{
+		const size_t block_size = (ref_seqs<_val>::get().mapped() ? 0 : ref_seqs<_val>::get().raw_len()*sizeof(_val))
+				+ (ref_ids::get().mapped() ? 0 : ref_ids::get().raw_len())
+				+ (ref_seqs<_val>::get().get_length() + ref_ids::get().get_length() + 2) * sizeof(size_t)
+				+ sizeof(seed_histogram);
+		if(!prefetch_budget.reserve(reserved_, 2*block_size))
+			return false;
+		thread_ = new thread(read, this);
+		return true;
+	}
+
+private:
+
+	static void read(Reference_loader *me)
+	{
+		try {
+			me->seqs_ = me->db_file_.template load_seqs<_val>();
+			me->ids_ = me->db_file_.load_ids();
+			me->hst_ = new seed_histogram;
+			me->db_file_.read(me->hst_, 1);
+		} catch(std::exception &e) {
+			exception_state.set(e);
+		}
+	}
+
+	void join()
+	{
+		if(thread_ == 0)
+			return;
+		thread_->join();
+		delete thread_;
+		thread_ = 0;
+	}
+
+	Database_file &db_file_;
+	Sequence_set<_val> *seqs_;
+	String_set<char,0> *ids_;
+	seed_histogram *hst_;
+	thread *thread_;
+	size_t reserved_;
+
+};
 
 size_t max_id_len(const String_set<char,0> &ids)
 {
@@ -126,12 +225,8 @@ struct Masking
 		}
 
 		timer.finish();
-		size_t n = 0;
-		for(unsigned i=range.begin();i<range.end();++i) {
-			n += counts[i];
-			const size_t ht_size (std::max(static_cast<size_t>(static_cast<float>(counts[i]) * 1.3), static_cast<size_t>(counts[i] + 1)));
-			pos_filters[sid][i] = auto_ptr<filter_table> (new filter_table(ht_size));
-		}
+		const size_t n = std::accumulate(counts.begin() + range.begin(), counts.begin() + range.end(), (size_t)0);
+		pos_filters[sid].init(range.begin(), range.end(), &counts[0]);
 		log_stream << "Hit cap = " << program_options::hit_cap << std::endl;
 		log_stream << "Low complexity seeds = " << n << std::endl;
 
@@ -139,6 +234,7 @@ struct Masking
 #pragma omp parallel for schedule(dynamic)
 		for(unsigned seedp=range.begin(); seedp<range.end(); ++seedp) {
 			unsigned n = 0;
+			pos_filters[sid].clear(seedp);
 			typename sorted_list<_loc>::Type::iterator i = idx.get_partition_begin(seedp);
 			while(!i.at_end()) {
 				if(i.n > program_options::hit_cap)
@@ -156,11 +252,11 @@ struct Masking
 	bool get(const _val *pos, unsigned sid) const
 	{
 		uint64_t seed;
-		shape_config::get().get_shape(sid).set_seed(seed, pos);
-		const filter_table::entry *e;
-		if((e = pos_filters[sid][seed_partition(seed)]->operator [](seed_partition_offset(seed))) != 0) {
+		shape_config::get().get_shape(sid).set_seed(seed, ref_seqs<_val>::data_->reduced(pos));
+		const unsigned treshold (pos_filters[sid].get(seed_partition(seed), seed_partition_offset(seed)));
+		if(treshold != 0) {
 			const size_t offset (pos - ref_seqs<_val>::data_->data(0));
-			return !position_filter(offset, e->value, seed_partition_offset(seed));
+			return !position_filter(offset, treshold, seed_partition_offset(seed));
 		} else
 			return false;
 	}
@@ -179,7 +275,7 @@ private:
 			} else
 				*(i.get(k++)) = *(i.get(j));
 		i.get(k)->value = 0;
-		pos_filters[sid][p]->insert(i.key(), treshold);
+		pos_filters[sid].insert(p, i.key(), treshold);
 		return count;
 	}
 
@@ -192,8 +288,7 @@ private:
 
 private:
 
-	typedef hash_table<uint32_t, uint8_t, value_compare<uint8_t, 0>, murmur_hash> filter_table;
-	auto_ptr<filter_table> pos_filters[Const::max_shapes][Const::seedp];
+	Filter_table pos_filters[Const::max_shapes];
 
 } ref_masking;
 
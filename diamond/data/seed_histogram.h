@@ -26,6 +26,7 @@ Author: Benjamin Buchfink
 #include "../basic/seed.h"
 #include "sequence_set.h"
 #include "../basic/shape_config.h"
+#include "../basic/seed_enumerator.h"
 
 using std::vector;
 using boost::thread;
@@ -113,24 +114,35 @@ private:
 			const vector<shape_config> &cfgs)
 	{
 		assert(seqp < Const::seqp);
-		uint64_t key;
 		for(size_t i=begin;i<end;++i) {
 
 			assert(i < seqs.get_length());
 			const sequence<const _val> seq = seqs[i];
 			if(seq.length() < Const::min_shape_len) continue;
-			for(unsigned j=0;j<seq.length()+1-Const::min_shape_len; ++j)
-				for(vector<shape_config>::const_iterator cfg = cfgs.begin(); cfg != cfgs.end(); ++cfg) {
-					assert(cfg->mode() < Const::index_modes);
-					assert(cfg->count() <= Const::max_shapes);
-					for(unsigned k=0;k<cfg->count(); ++k)
-						if(j+cfg->get_shape(k).length_ < seq.length()+1 && cfg->get_shape(k).set_seed(key, &seq[j]))
-							++data_[cfg->mode()][k][seqp][seed_partition(key)];
+			for(vector<shape_config>::const_iterator cfg = cfgs.begin(); cfg != cfgs.end(); ++cfg) {
+				assert(cfg->mode() < Const::index_modes);
+				assert(cfg->count() <= Const::max_shapes);
+				for(unsigned k=0;k<cfg->count(); ++k) {
+					const shape &sh = cfg->get_shape(k);
+					if(seq.length() < sh.length_) continue;
+					Count_seed count (data_[cfg->mode()][k][seqp]);
+					Seed_enumerator (sh).enumerate(seqs.reduced(i), seq.length() - sh.length_ + 1, count);
 				}
+			}
 
 		}
 	}
 
+	struct Count_seed
+	{
+		Count_seed(size_t *counts):
+			counts (counts)
+		{ }
+		void operator()(unsigned j, uint64_t key)
+		{ ++counts[seed_partition(key)]; }
+		size_t *counts;
+	};
+
 	template<typename _val>
 	static vector<shape_config> shape_configs()
 	{
@@ -0,0 +1,216 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef SEED_INDEX_H_
+#define SEED_INDEX_H_
+
+#include <memory>
+#include "../util/binary_file.h"
+#include "reference.h"
+
+using std::auto_ptr;
+
+struct Seed_index_header
+{
+	Seed_index_header():
+		unique_id (0x5d1a0c3e9b7f2461llu),
+		build (Const::build_version),
+		index_mode (0),
+		shapes (0),
+		n_blocks (0),
+		sequences (0),
+		letters (0),
+		max_seed_freq (0),
+		table_offset (0)
+	{ }
+	uint64_t unique_id;
+	uint32_t build, index_mode, shapes, n_blocks;
+	size_t sequences, letters;
+	double max_seed_freq;
+	size_t table_offset;
+};
+
+/* Precomputed reference seed lists, stored next to the database as <db>.sidx.
+   For every block and shape the sorted_list entries of all seed partitions are
+   written consecutively, starting at a page boundary. */
+
+struct Seed_index_writer
+{
+
+	Seed_index_writer():
+		out_ (program_options::seed_index_file_name()),
+		pos_ (0)
+	{
+		header_.index_mode = program_options::index_mode;
+		header_.shapes = shape_config::get().count();
+		header_.max_seed_freq = program_options::max_seed_freq;
+		write(&header_, 1);
+	}
+
+	template<typename _val>
+	void write_block(const Sequence_set<_val> &seqs, const seed_histogram &hst, bool long_addressing)
+	{
+		if(long_addressing)
+			write_block<_val,uint64_t>(seqs, hst);
+		else
+			write_block<_val,uint32_t>(seqs, hst);
+	}
+
+	void close()
+	{
+		header_.n_blocks = entry_size_.size();
+		header_.sequences = ref_header.sequences;
+		header_.letters = ref_header.letters;
+		header_.table_offset = pos_;
+		out_.write(offsets_);
+		out_.write(entry_size_);
+		out_.seekp(0);
+		out_.write(&header_, 1);
+		out_.close();
+	}
+
+private:
+
+	template<typename _val, typename _loc>
+	void write_block(const Sequence_set<_val> &seqs, const seed_histogram &hst)
+	{
+		typedef typename sorted_list<_loc>::Type List;
+		char *buffer = List::alloc_buffer(hst);
+		const ::partition p (Const::seedp, program_options::lowmem);
+		for(unsigned sid=0;sid<shape_config::get().count();++sid) {
+			align();
+			offsets_.push_back(pos_);
+			for(unsigned chunk=0;chunk<p.parts;++chunk) {
+				const List list (buffer, seqs, shape_config::get().get_shape(sid), hst.get(program_options::index_mode, sid), seedp_range(p.getMin(chunk), p.getMax(chunk)));
+				write(list.data(), list.size());
+			}
+		}
+		entry_size_.push_back(sizeof(typename List::entry));
+		delete[] buffer;
+	}
+
+	template<typename _t>
+	void write(const _t *ptr, size_t count)
+	{
+		out_.write(ptr, count);
+		pos_ += count * sizeof(_t);
+	}
+
+	void align()
+	{
+		static const char zero[alignment] = { 0 };
+		write(zero, round_up(pos_, (size_t)alignment) - pos_);
+	}
+
+	enum { alignment = 4096 };
+
+	Seed_index_header header_;
+	Output_stream out_;
+	size_t pos_;
+	vector<size_t> offsets_;
+	vector<uint32_t> entry_size_;
+
+};
+
+struct Seed_index
+{
+
+	static Seed_index* open(size_t entry_size)
+	{
+		try {
+			auto_ptr<Seed_index> index (new Seed_index ());
+			if(!index->compatible(entry_size))
+				return 0;
+			verbose_stream << "Using precomputed seed index " << index->file_.file_name << endl;
+			return index.release();
+		} catch(file_open_exception &) {
+			return 0;
+		}
+	}
+
+	template<typename _loc>
+	typename sorted_list<_loc>::Type::entry* get(unsigned block, unsigned sid, const shape_histogram &hst, const seedp_range &range, char *buffer)
+	{
+		typedef typename sorted_list<_loc>::Type::entry Entry;
+		const size_t offset = offsets_[block*header_.shapes + sid] + hst_size(hst, seedp_range(0, range.begin())) * sizeof(Entry),
+				n = hst_size(hst, range) * sizeof(Entry);
+		if(map_.get()) {
+			if(offset + n > map_->size())
+				THROW_EXCEPTION(file_io_exception, map_->file_name);
+			return reinterpret_cast<Entry*>(map_->data(offset));
+		}
+		file_.seekg(offset);
+		if(file_.read(buffer, n) != n)
+			THROW_EXCEPTION(file_io_exception, file_.file_name);
+		return reinterpret_cast<Entry*>(buffer);
+	}
+
+	void release(const void *ptr, size_t n) const
+	{
+		if(map_.get())
+			map_->discard(ptr, n);
+	}
+
+private:
+
+	Seed_index():
+		file_ (program_options::seed_index_file_name()),
+		map_ (program_options::mmap_db ? new Mapped_file (file_.file_name) : 0)
+	{
+		if(file_.read(&header_, 1) != 1)
+			THROW_EXCEPTION(file_io_exception, file_.file_name);
+		if(header_.unique_id == Seed_index_header().unique_id && header_.build == Const::build_version) {
+			file_.seekg(header_.table_offset);
+			file_.read(offsets_);
+			file_.read(entry_size_);
+		}
+	}
+
+	bool compatible(size_t entry_size) const
+	{
+		if(header_.unique_id != Seed_index_header().unique_id || header_.build != Const::build_version)
+			return false;
+		if(header_.n_blocks != ref_header.n_blocks || header_.sequences != ref_header.sequences || header_.letters != ref_header.letters) {
+			verbose_stream << "Seed index does not match the database, ignoring it." << endl;
+			return false;
+		}
+		if(header_.index_mode != program_options::index_mode
+				|| header_.shapes < shape_config::get().count()
+				|| header_.max_seed_freq != program_options::max_seed_freq) {
+			verbose_stream << "Seed index was built with different seed parameters, ignoring it." << endl;
+			return false;
+		}
+		for(vector<uint32_t>::const_iterator i = entry_size_.begin(); i != entry_size_.end(); ++i)
+			if(*i != entry_size)
+				return false;
+		return true;
+	}
+
+	Input_stream file_;
+	const auto_ptr<Mapped_file> map_;
+	Seed_index_header header_;
+	vector<size_t> offsets_;
+	vector<uint32_t> entry_size_;
+
+};
+
+auto_ptr<Seed_index> ref_seed_index;
+
+#endif /* SEED_INDEX_H_ */
@@ -25,6 +25,7 @@ Author: Benjamin Buchfink
 #include <string>
 #include "../basic/sequence.h"
 #include "string_set.h"
+#include "../basic/reduction.h"
 
 using std::cout;
 using std::endl;
@@ -41,6 +42,32 @@ struct Sequence_set : public String_set<_val>
 		String_set<_val> (file)
 	{ }
 
+	Sequence_set(Input_stream &file, const Mapped_file &map):
+		String_set<_val> (file, map)
+	{ }
+
+	/* Builds a parallel array holding the reduced alphabet class of every
+	 * letter, with bit 7 set for masked letters and padding, so that seed
+	 * computation and the reduced match filter need no table lookups. */
+	void build_reduced()
+	{
+		const size_t n (this->raw_len() + String_set<_val>::PERIMETER_PADDING);
+		reduced_.resize(n);
+		const _val *data (this->data());
+#pragma omp parallel for
+		for(long i=0;i<(long)n;++i) {
+			const _val l (data[i]);
+			reduced_[i] = Reduction<_val>::reduction(mask_critical(l))
+					| (l == Value_traits<_val>::MASK_CHAR || l == String_set<_val>::PADDING_CHAR ? 0x80 : 0);
+		}
+	}
+
+	const uint8_t* reduced(const _val *p) const
+	{ return &reduced_[p - this->data()]; }
+
+	const uint8_t* reduced(size_t i) const
+	{ return reduced(this->ptr(i)); }
+
 	void print_stats() const
 	{ verbose_stream << "Sequences = " << this->get_length() << ", letters = " << this->letters() << endl; }
 
@@ -110,6 +137,10 @@ struct Sequence_set : public String_set<_val>
 			return l*3;
 	}
 
+private:
+
+	vector<uint8_t> reduced_;
+
 };
 
 #endif /* SEQUENCE_SET_H_ */
@@ -24,6 +24,8 @@ Author: Benjamin Buchfink
 #include "../util/util.h"
 #include "seed_histogram.h"
 #include "../basic/packed_loc.h"
+#include "../util/radix_sort.h"
+#include "../basic/seed_enumerator.h"
 
 template<typename _pos>
 struct sorted_list
@@ -69,12 +71,31 @@ struct sorted_list
 					sh,
 					range);
 
+		for(unsigned i=0;i<Const::seqp;++i)
+			delete iterators[i];
+
 		timer.go("Sorting seed list");
-#pragma omp parallel for schedule(dynamic)
-		for(unsigned i=0;i<Const::seedp;++i)
-			std::sort(ptr_begin(i), ptr_end(i));
+		const unsigned bits = key_bits<_val>(sh);
+#pragma omp parallel
+		{
+			vector<entry> buffer;
+#pragma omp for schedule(dynamic)
+			for(unsigned i=0;i<Const::seedp;++i)
+				sort_partition(ptr_begin(i), ptr_end(i), bits, buffer);
+		}
 	}
 
+	sorted_list(entry *data, const shape_histogram &hst, const seedp_range &range):
+		limits_ (hst, range),
+		data_ (data)
+	{ }
+
+	const entry* data() const
+	{ return data_; }
+
+	size_t size() const
+	{ return limits_.back(); }
+
 	template<typename _t>
 	struct Iterator_base
 	{
@@ -114,6 +135,43 @@ struct sorted_list
 	iterator get_partition_begin(unsigned p) const
 	{ return iterator (ptr_begin(p), ptr_end(p)); }
 
+	struct Entry_key
+	{
+		unsigned operator()(const entry &e) const
+		{ return e.key; }
+	};
+
+	enum { radix_sort_threshold = 1024 };
+
+	/* buffer is kept by the calling thread for the partitions of one list. */
+	static void sort_partition(entry *begin, entry *end, unsigned bits, vector<entry> &buffer)
+	{
+		const size_t n = end - begin;
+		if(n < radix_sort_threshold) {
+			std::sort(begin, end);
+			return;
+		}
+		if(buffer.size() < n)
+			buffer.resize(n);
+		radix_sort(begin, end, buffer.data(), bits, Entry_key ());
+	}
+
+	template<typename _val>
+	static unsigned key_bits(const shape &sh)
+	{
+		uint64_t max = 1;
+		for(unsigned i=0;i<sh.weight_;++i) {
+			max *= Reduction<_val>::reduction.size();
+			if(max > (uint64_t(1) << (32 + Const::seedp_bits)))
+				return 32;
+		}
+		max = (max - 1) >> Const::seedp_bits;
+		unsigned bits = 0;
+		while(max >> bits)
+			++bits;
+		return bits;
+	}
+
 private:
 
 	struct buffered_iterator
@@ -148,6 +206,20 @@ private:
 		uint8_t  n[Const::seedp];
 	};
 
+	struct Push_seed
+	{
+		Push_seed(buffered_iterator *it, size_t begin, const seedp_range &range):
+			it (it),
+			begin (begin),
+			range (range)
+		{ }
+		void operator()(unsigned j, uint64_t key)
+		{ it->push(key, begin + j, range); }
+		buffered_iterator *it;
+		const size_t begin;
+		const seedp_range &range;
+	};
+
 	entry* ptr_begin(unsigned i) const
 	{ return &data_[limits_[i]]; }
 
@@ -163,14 +235,11 @@ private:
 	template<typename _val>
 	static void build_seqp(const Sequence_set<_val> &seqs, unsigned begin, unsigned end, buffered_iterator *it, const shape &sh, const seedp_range &range)
 	{
-		uint64_t key;
 		for(size_t i=begin;i<end;++i) {
 			const sequence<const _val> seq = seqs[i];
 			if(seq.length()<sh.length_) continue;
-			for(unsigned j=0;j<seq.length()-sh.length_+1; ++j) {
-				if(sh.set_seed(key, &seq[j]))
-					it->push(key, seqs.position(i, j), range);
-			}
+			Push_seed push (it, seqs.position(i, 0), range);
+			Seed_enumerator (sh).enumerate(seqs.reduced(i), seq.length()-sh.length_+1, push);
 		}
 		it->flush();
 	}
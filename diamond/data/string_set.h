@@ -22,6 +22,7 @@ Author: Benjamin Buchfink
 #define STRING_SET_H_
 
 #include <vector>
+#include <algorithm>
 
 using std::vector;
 
@@ -33,8 +34,12 @@ struct String_set
 	static const _t PADDING_CHAR;
 
 	String_set():
-		data_ (PERIMETER_PADDING)
-	{ limits_.push_back(PERIMETER_PADDING); }
+		data_ (PERIMETER_PADDING),
+		map_ (0)
+	{
+		limits_.push_back(PERIMETER_PADDING);
+		set_view();
+	}
 
 	void finish_reserve()
 	{
@@ -43,6 +48,7 @@ struct String_set
 			data_[i] = PADDING_CHAR;
 			data_[raw_len()+i] = PADDING_CHAR;
 		}
+		set_view();
 	}
 
 	void push_back(const vector<_t> &v)
@@ -50,6 +56,28 @@ struct String_set
 		limits_.push_back(raw_len() + v.size() + _padding);
 		data_.insert(data_.end(), v.begin(), v.end());
 		data_.insert(data_.end(), _padding, PADDING_CHAR);
+		set_view();
+	}
+
+	/* Makes room for n more strings with the given total length, at least
+	 * doubling the capacity when it has to grow. */
+	void reserve(size_t n, size_t letters)
+	{
+		const size_t limits (limits_.size() + n), data (data_.size() + letters + n*_padding + PERIMETER_PADDING);
+		if(limits > limits_.capacity())
+			limits_.reserve(std::max(limits, limits_.capacity()*2));
+		if(data > data_.capacity())
+			data_.reserve(std::max(data, data_.capacity()*2));
+		set_view();
+	}
+
+	/* Appends a string of length n to be written through ptr(). */
+	void push_back(size_t n)
+	{
+		limits_.push_back(raw_len() + n + _padding);
+		data_.resize(data_.size() + n);
+		data_.insert(data_.end(), _padding, PADDING_CHAR);
+		set_view();
 	}
 
 	void fill(size_t n, _t v)
@@ -57,19 +85,20 @@ struct String_set
 		limits_.push_back(raw_len() + n + _padding);
 		data_.insert(data_.end(), n, v);
 		data_.insert(data_.end(), _padding, PADDING_CHAR);
+		set_view();
 	}
 
 	_t* ptr(size_t i)
-	{ return &data_[limits_[i]]; }
+	{ return &data_ptr_[limits_ptr_[i]]; }
 
 	const _t* ptr(size_t i) const
-	{ return &data_[limits_[i]]; }
+	{ return &data_ptr_[limits_ptr_[i]]; }
 
 	size_t length(size_t i) const
-	{ return limits_[i+1] - limits_[i] - _padding; }
+	{ return limits_ptr_[i+1] - limits_ptr_[i] - _padding; }
 
 	size_t get_length() const
-	{ return limits_.size() - 1; }
+	{ return limits_size_ - 1; }
 
 	void save(Output_stream &file) const
 	{
@@ -77,34 +106,53 @@ struct String_set
 		file.write(data_);
 	}
 
-	String_set(Input_stream &file)
+	String_set(Input_stream &file):
+		map_ (0)
 	{
 		file.read(limits_);
 		file.read(data_);
+		set_view();
+	}
+
+	/* The letters are used in place. The limits are copied since the file
+	 * layout gives them no alignment. */
+	String_set(Input_stream &file, const Mapped_file &map):
+		map_ (&map)
+	{
+		file.read(limits_);
+		limits_ptr_ = limits_.data();
+		limits_size_ = limits_.size();
+		data_ptr_ = file.map<_t>(map, data_size_);
+	}
+
+	~String_set()
+	{
+		if(map_)
+			map_->discard(data_ptr_, data_size_ * sizeof(_t));
 	}
 
 	size_t raw_len() const
-	{ return limits_.back(); }
+	{ return limits_ptr_[limits_size_-1]; }
 
 	size_t letters() const
 	{ return raw_len() - get_length() - PERIMETER_PADDING; }
 
 	_t* data(ptrdiff_t p = 0)
-	{ return &data_[p]; }
+	{ return &data_ptr_[p]; }
 
 	const _t* data(ptrdiff_t p = 0) const
-	{ return &data_[p]; }
+	{ return &data_ptr_[p]; }
 
 	size_t position(const _t* p) const
 	{ return p - data(); }
 
 	size_t position(size_t i, size_t j) const
-	{ return limits_[i] + j; }
+	{ return limits_ptr_[i] + j; }
 
 	std::pair<size_t,size_t> local_position(size_t p) const
 	{
-		size_t i = std::upper_bound(limits_.begin(), limits_.end(), p) - limits_.begin() - 1;
-		return std::pair<size_t,size_t> (i, p - limits_[i]);
+		size_t i = std::upper_bound(limits_ptr_, limits_ptr_ + limits_size_, p) - limits_ptr_ - 1;
+		return std::pair<size_t,size_t> (i, p - limits_ptr_[i]);
 	}
 
 	sequence<const _t> operator[](size_t i) const
@@ -113,10 +161,28 @@ struct String_set
 	sequence<_t> operator[](size_t i)
 	{ return sequence<_t> (ptr(i), length(i)); }
 
+	bool mapped() const
+	{ return map_ != 0; }
+
 private:
 
+	String_set(const String_set&);
+	String_set& operator=(const String_set&);
+
+	void set_view()
+	{
+		data_ptr_ = data_.data();
+		data_size_ = data_.size();
+		limits_ptr_ = limits_.data();
+		limits_size_ = limits_.size();
+	}
+
 	vector<_t> data_;
 	vector<size_t> limits_;
+	_t *data_ptr_;
+	size_t *limits_ptr_;
+	size_t data_size_, limits_size_;
+	const Mapped_file *map_;
 
 };
 
@@ -18,29 +18,24 @@ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR P
 Author: Benjamin Buchfink
 ****/
 
-#ifndef DP_MATRIX_H_
-#define DP_MATRIX_H_
-
-#include <vector>
-#include <boost/thread/tss.hpp>
-#include "score_vector.h"
+/* Included by sw_kernel.h once for every instruction set, inside its namespace. */
 
 using std::vector;
 using boost::thread_specific_ptr;
 
-template<typename _score>
-void array_clear(score_vector<_score> *v, unsigned n)
+template<typename _sv>
+void array_clear(_sv *v, unsigned n)
 {
-	score_vector<_score> *end (v+n);
+	_sv *end (v+n);
 	while(v < end)
-		*(v++) = score_vector<_score> ();
+		*(v++) = _sv ();
 }
 
-template<typename _score>
+template<typename _score, unsigned _bits = 128>
 struct DP_matrix
 {
 
-	typedef score_vector<_score> sv;
+	typedef score_vector<_score,_bits> sv;
 
 	struct Column_iterator
 	{
@@ -75,10 +70,8 @@ struct DP_matrix
 		scores_ (scores_ptr),
 		hgap_ (hgap_ptr)
 	{
-		scores_->resize(2*band+1);
-		hgap_->resize(2*band+2);
-		hgap_front_ = &hgap_->front();
-		score_front_ = &scores_->front();
+		hgap_front_ = aligned_front(*hgap_, 2*band+2);
+		score_front_ = aligned_front(*scores_, 2*band+1);
 	}
 
 	inline void clear()
@@ -136,16 +129,21 @@ struct DP_matrix
 
 private:
 
-	static thread_specific_ptr<vector<sv> > scores_ptr;
-	static thread_specific_ptr<vector<sv> > hgap_ptr;
+	// the default allocator does not guarantee the alignment of 256/512 bit vectors
+	static sv* aligned_front(vector<char> &v, size_t n)
+	{
+		v.resize((n+1)*sizeof(sv));
+		return reinterpret_cast<sv*>(((size_t)&v.front() + sizeof(sv) - 1) & ~(sizeof(sv) - 1));
+	}
+
+	static thread_specific_ptr<vector<char> > scores_ptr;
+	static thread_specific_ptr<vector<char> > hgap_ptr;
 
 	const unsigned rows_, band_, padding_;
 	sv *hgap_front_, *score_front_;
-	Tls<vector<sv> > scores_, hgap_;
+	Tls<vector<char> > scores_, hgap_;
 
 };
 
-template<typename _score> thread_specific_ptr<vector<score_vector<_score> > > DP_matrix<_score>::scores_ptr;
-template<typename _score> thread_specific_ptr<vector<score_vector<_score> > > DP_matrix<_score>::hgap_ptr;
-
-#endif /* DP_MATRIX_H_ */
+template<typename _score, unsigned _bits> thread_specific_ptr<vector<char> > DP_matrix<_score,_bits>::scores_ptr;
+template<typename _score, unsigned _bits> thread_specific_ptr<vector<char> > DP_matrix<_score,_bits>::hgap_ptr;
@@ -26,21 +26,121 @@ Author: Benjamin Buchfink
 #include "../util/direction.h"
 #include "scalar_traceback.h"
 
-template<typename _val, typename _dir, typename _score, typename _traceback>
-local_match<_val> floating_sw_dir(const _val *query, const _val *subject, int band, _score xdrop, _score gap_open, _score gap_extend)
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+template<typename _val, typename _dir, typename _score, typename _dp>
+inline void floating_sw_column(typename _dp::Column_iterator &it,
+		const _val *x,
+		_val y,
+		_score gap_open,
+		_score gap_extend,
+		_score &column_max,
+		int &i_max)
 {
 	using std::max;
+	_score vgap = _dp::NEG_MIN;
+	for(; it.valid() && get_dir(x, it.row(), _dir()) != String_set<_val>::PADDING_CHAR; ++it) {
+		const _score match_score = score_matrix::get().letter_score(y, get_dir(x, it.row(), _dir()));
+		const _score s = max(max(it.diag() + match_score, vgap), it.hgap_in());
+		if(s > column_max) {
+			column_max = s;
+			i_max = it.row();
+		}
+		const _score open = s - gap_open;
+		vgap = max(vgap - gap_extend, open);
+		it.hgap_out() = max(it.hgap_in() - gap_extend, open);
+		it.score() = s;
+	}
+}
+
+#ifdef __AVX2__
+
+/* Computes the band of one column 8 cells at a time. Since gap_open >= gap_extend,
+   the vertical gap entering row k equals max(NEG_MIN, max_{j<k} s0[j] - gap_open + (j+1)*gap_extend) - k*gap_extend
+   with s0 = max(diag + match, hgap_in), which turns the column dependency into a prefix maximum.
+   The result is identical to the scalar loop above. */
+
+template<typename _val, typename _dir, typename _dp>
+inline void floating_sw_column_avx2(typename _dp::Column_iterator &it,
+		const _val *x,
+		_val y,
+		int *profile,
+		int gap_open,
+		int gap_extend,
+		int &column_max,
+		int &i_max)
+{
+	const int i0 = it.row(), n_max = it.remaining();
+	const int8_t *row_scores = &score_matrix::get().matrix8()[int(y) << 5];
+	int n = 0;
+	_val c;
+	while(n < n_max && (c = get_dir(x, i0+n, _dir())) != String_set<_val>::PADDING_CHAR)
+		profile[n++] = row_scores[int(c)];
+	if(n == 0)
+		return;
+
+	const int *diag = it.diag_ptr(), *hgap_in = it.hgap_in_ptr();
+	int *score = it.score_ptr(), *hgap_out = it.hgap_out_ptr();
+	const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+			shift1 = _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6),
+			shift2 = _mm256_setr_epi32(0, 0, 0, 1, 2, 3, 4, 5),
+			shift4 = _mm256_setr_epi32(0, 0, 0, 0, 0, 1, 2, 3),
+			last = _mm256_set1_epi32(7),
+			go = _mm256_set1_epi32(gap_open),
+			ge = _mm256_set1_epi32(gap_extend),
+			ge8 = _mm256_set1_epi32(8*gap_extend),
+			min_score = _mm256_set1_epi32(std::numeric_limits<int>::min());
+	__m256i kge = _mm256_mullo_epi32(lane, ge),
+			carry = _mm256_set1_epi32(_dp::NEG_MIN),
+			best = min_score;
+
+	for(int k=0;k<n;k+=8) {
+		const __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(n-k), lane);
+		const __m256i h = _mm256_maskload_epi32(hgap_in+k, mask);
+		const __m256i s0 = _mm256_max_epi32(_mm256_add_epi32(_mm256_maskload_epi32(diag+k, mask), _mm256_maskload_epi32(profile+k, mask)), h);
+		__m256i u = _mm256_add_epi32(_mm256_sub_epi32(s0, go), _mm256_add_epi32(kge, ge));
+		u = _mm256_max_epi32(u, _mm256_permutevar8x32_epi32(u, shift1));
+		u = _mm256_max_epi32(u, _mm256_permutevar8x32_epi32(u, shift2));
+		u = _mm256_max_epi32(u, _mm256_permutevar8x32_epi32(u, shift4));
+		const __m256i vgap = _mm256_max_epi32(carry, _mm256_blend_epi32(_mm256_permutevar8x32_epi32(u, shift1), carry, 1));
+		carry = _mm256_max_epi32(carry, _mm256_permutevar8x32_epi32(u, last));
+		const __m256i s = _mm256_max_epi32(s0, _mm256_sub_epi32(vgap, kge));
+		_mm256_maskstore_epi32(score+k, mask, s);
+		_mm256_maskstore_epi32(hgap_out+k, mask, _mm256_max_epi32(_mm256_sub_epi32(h, ge), _mm256_sub_epi32(s, go)));
+		best = _mm256_max_epi32(best, _mm256_blendv_epi8(min_score, s, mask));
+		kge = _mm256_add_epi32(kge, ge8);
+	}
 
+	best = _mm256_max_epi32(best, _mm256_permute2x128_si256(best, best, 1));
+	best = _mm256_max_epi32(best, _mm256_shuffle_epi32(best, 0x4e));
+	best = _mm256_max_epi32(best, _mm256_shuffle_epi32(best, 0xb1));
+	const int m = _mm256_extract_epi32(best, 0);
+	if(m > column_max) {
+		column_max = m;
+		int k = 0;
+		while(score[k] != m)
+			++k;
+		i_max = i0 + k;
+	}
+}
+
+#endif
+
+template<typename _val, typename _dir, typename _score, typename _traceback>
+local_match<_val> floating_sw_dir(const _val *query, const _val *subject, int band, _score xdrop, _score gap_open, _score gap_extend)
+{
+	typedef Scalar_dp_matrix<_score,_traceback> Dp;
 	_score max_score = 0, column_max = 0;
 	int j = 0, i_max = -1, j_best = -1, i_best = -1;
-	Scalar_dp_matrix<_score,_traceback> mtx (band);
+	Dp mtx (band);
 	const _val *x = query, *y = subject;
 
 	while(*y != String_set<_val>::PADDING_CHAR && max_score - column_max < xdrop) {
-		typename Scalar_dp_matrix<_score,_traceback>::Column_iterator it = mtx.column(j, i_max);
+		typename Dp::Column_iterator it = mtx.column(j, i_max);
 		if(get_dir(x, it.row(), _dir()) == String_set<_val>::PADDING_CHAR)
 			break;
-		_score vgap = Scalar_dp_matrix<_score,_traceback>::NEG_MIN;
 		if(get_dir(x, i_max+1, _dir()) == String_set<_val>::PADDING_CHAR) {
 			column_max = std::numeric_limits<_score>::min();
 		} else {
@@ -48,18 +148,12 @@ local_match<_val> floating_sw_dir(const _val *query, const _val *subject, int ba
 			column_max += score_matrix::get().letter_score(mask_critical(*y), get_dir(x, i_max, _dir()));
 		}
 
-		for(; it.valid() && get_dir(x, it.row(), _dir()) != String_set<_val>::PADDING_CHAR; ++it) {
-			const _score match_score = score_matrix::get().letter_score(mask_critical(*y), get_dir(x, it.row(), _dir()));
-			const _score s = max(max(it.diag() + match_score, vgap), it.hgap_in());
-			if(s > column_max) {
-				column_max = s;
-				i_max = it.row();
-			}
-			const _score open = s - gap_open;
-			vgap = max(vgap - gap_extend, open);
-			it.hgap_out() = max(it.hgap_in() - gap_extend, open);
-			it.score() = s;
-		}
+#ifdef __AVX2__
+		if(program_options::have_avx2)
+			floating_sw_column_avx2<_val,_dir,Dp>(it, x, mask_critical(*y), mtx.profile(), gap_open, gap_extend, column_max, i_max);
+		else
+#endif
+			floating_sw_column<_val,_dir,_score,Dp>(it, x, mask_critical(*y), gap_open, gap_extend, column_max, i_max);
 
 		if(column_max > max_score) {
 			max_score = column_max;
@@ -94,4 +188,14 @@ void floating_sw(const _val *query, local_match<_val> &segment, int band, _score
 	}
 }
 
+template<typename _val, typename _score>
+_score floating_sw_score(const _val *query, const _val *subject, int band, _score xdrop, _score gap_open, _score gap_extend)
+{
+	const local_match<_val> right (floating_sw_dir<_val,Right,_score,Score_only>(query, subject, band, xdrop, gap_open, gap_extend));
+	const local_match<_val> left (floating_sw_dir<_val,Left,_score,Score_only>(query, subject, band, xdrop, gap_open, gap_extend));
+	if(left.query_len_ > 0)
+		return right.score_ + left.score_ - score_matrix::get().letter_score(*query, mask_critical(*subject));
+	return right.score_;
+}
+
 #endif /* FLOATING_SW_H_ */
@@ -87,6 +87,21 @@ struct Scalar_dp_matrix
 		inline _score& hgap_out()
 		{ return *hgap_.second; }
 
+		inline int remaining() const
+		{ return end_ - score_.second; }
+
+		inline _score* score_ptr()
+		{ return score_.second; }
+
+		inline const _score* diag_ptr() const
+		{ return score_.first; }
+
+		inline const _score* hgap_in_ptr() const
+		{ return hgap_.first; }
+
+		inline _score* hgap_out_ptr()
+		{ return hgap_.second; }
+
 		inline void operator++()
 		{
 			++i_;
@@ -115,15 +130,20 @@ struct Scalar_dp_matrix
 		band_max_ (2*band+1),
 		current_i_ (-1),
 		score_ (score_ptr),
-		hgap_ (hgap_ptr)
+		hgap_ (hgap_ptr),
+		profile_ (profile_ptr)
 	{
 		score_->init(band_max_, band_+1, 1, NEG_MIN);
 		hgap_->init(band_max_, band_+1, 1, NEG_MIN);
+		profile_->resize(band_max_);
 	}
 
 	const typename Score_buffer<_score,_traceback>::Type& score_buffer() const
 	{ return *score_; }
 
+	_score* profile()
+	{ return &profile_->front(); }
+
 	static const _score NEG_MIN = -65536;
 
 private:
@@ -132,12 +152,15 @@ private:
 	int current_i_;
 	Tls<typename Score_buffer<_score,_traceback>::Type> score_;
 	Tls<Double_buffer<_score> > hgap_;
+	Tls<vector<_score> > profile_;
 	static thread_specific_ptr<typename Score_buffer<_score,_traceback>::Type> score_ptr;
 	static thread_specific_ptr<Double_buffer<_score> > hgap_ptr;
+	static thread_specific_ptr<vector<_score> > profile_ptr;
 
 };
 
 template<typename _score, typename _traceback> thread_specific_ptr<typename Score_buffer<_score,_traceback>::Type> Scalar_dp_matrix<_score,_traceback>::score_ptr;
 template<typename _score, typename _traceback> thread_specific_ptr<Double_buffer<_score> > Scalar_dp_matrix<_score,_traceback>::hgap_ptr;
+template<typename _score, typename _traceback> thread_specific_ptr<vector<_score> > Scalar_dp_matrix<_score,_traceback>::profile_ptr;
 
 #endif /* SCALAR_DP_MATRIX_H_ */
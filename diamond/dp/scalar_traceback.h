@@ -158,6 +158,11 @@ local_match<_val> traceback(const _val *query,
 		int i,
 		int j,
 		int score)
-{ return local_match<_val> (score); }
+{
+	local_match<_val> l (i == -1 ? 0 : score);
+	l.query_len_ = j + 1;
+	l.subject_len_ = i + 1;
+	return l;
+}
 
 #endif /* SCALAR_TRACEBACK_H_ */
@@ -18,17 +18,14 @@ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR P
 Author: Benjamin Buchfink
 ****/
 
-#ifndef SCORE_PROFILE_H_
-#define SCORE_PROFILE_H_
-
-#include <vector>
-#include "../basic/sequence.h"
-#include "score_vector.h"
+/* Included by sw_kernel.h once for every instruction set, inside its namespace. */
 
 using std::vector;
 
+template<unsigned _bits = 128>
 struct sequence_stream
 {
+	typedef typename simd_vector<_bits>::Type _simd;
 	sequence_stream():
 		next (buffer_len),
 		mask (0)
@@ -39,7 +36,7 @@ struct sequence_stream
 		mask = 0;
 	}
 	template<typename _val, typename _score>
-	inline const __m128i& get(const typename vector<sequence<const _val> >::const_iterator &begin,
+	inline const _simd& get(const typename vector<sequence<const _val> >::const_iterator &begin,
 					   const typename vector<sequence<const _val> >::const_iterator &end,
 					   unsigned pos,
 					   const _score&)
@@ -53,16 +50,18 @@ struct sequence_stream
 		  	  const typename vector<sequence<const _val> >::const_iterator &end,
 		 	  unsigned pos)
 	{
-		memset(data_, Value_traits<_val>::MASK_CHAR, buffer_len*16);
+		// filled as _score and copied, writing _score lanes into the vectors would break strict aliasing
+		_score letters[buffer_len*sizeof(_simd)/sizeof(_score)];
+		std::fill(letters, letters + buffer_len*sizeof(_simd)/sizeof(_score), _score(char(Value_traits<_val>::MASK_CHAR)));
 		unsigned n = 0;
 		typename vector<sequence<const _val> >::const_iterator it (begin);
 		assert(pos < it->length());
 		const unsigned read_len (std::min(unsigned(buffer_len), static_cast<unsigned>(it->length())-pos));
 		while(it < end) {
 			const uint8_t *src (reinterpret_cast<const uint8_t*>(it->data()) + pos);
-			_score *dest (reinterpret_cast<_score*>(data_) + n);
+			_score *dest (letters + n);
 			int clip (int(pos) - it->clipping_offset_);
-			if((mask & (1 << n)) == 0) {
+			if((mask & (uint64_t(1) << n)) == 0) {
 				if(copy_char(src, dest, mask, n, clip))
 				if(read_len > 1 && copy_char(src, dest, mask, n, clip))
 				if(read_len > 2 && copy_char(src, dest, mask, n, clip))
@@ -71,59 +70,62 @@ struct sequence_stream
 			++it;
 			++n;
 		}
+		memcpy(data_, letters, sizeof(data_));
 		next = 0;
 	}
 	template<typename _score>
-	static inline bool copy_char(const uint8_t*& src, _score*& dest, unsigned &mask, unsigned n, int &clip)
+	static inline bool copy_char(const uint8_t*& src, _score*& dest, uint64_t &mask, unsigned n, int &clip)
 	{
 		if(clip++ < 0) {
-			dest += 16/sizeof(_score);
+			dest += sizeof(_simd)/sizeof(_score);
 			++src;
 			return true;
 		}
 		if(*src == 0xff) {
-			mask |= 1 << n;
+			mask |= uint64_t(1) << n;
 			return false;
 		}
 		*dest = *(src++) & 0x7f;
-		dest += 16/sizeof(_score);
+		dest += sizeof(_simd)/sizeof(_score);
 		return true;
 	}
 	static const unsigned buffer_len = 4;
-	__m128i data_[buffer_len];
+	_simd data_[buffer_len];
 	unsigned next;
-	unsigned mask;
+	uint64_t mask;
 };
 
-template<typename _score>
+template<typename _score, unsigned _bits = 128>
 struct score_profile
 {
 
+	typedef score_vector<_score,_bits> sv;
+	typedef typename simd_vector<_bits>::Type _simd;
+
 	template<typename _val>
-	inline void set(const __m128i &seq)
+	inline void set(const _simd &seq)
 	{
-		assert(sizeof(data_)/sizeof(score_vector<_score>) >= Value_traits<_val>::ALPHABET_SIZE);
+		assert(sizeof(data_)/sizeof(sv) >= Value_traits<_val>::ALPHABET_SIZE);
 		unsigned j = 0;
 		do {
-			data_[j] = score_vector<_score> (j, seq);
+			data_[j] = sv (j, seq);
 			++j;
-			data_[j] = score_vector<_score> (j, seq);
+			data_[j] = sv (j, seq);
 			++j;
-			data_[j] = score_vector<_score> (j, seq);
+			data_[j] = sv (j, seq);
 			++j;
-			data_[j] = score_vector<_score> (j, seq);
+			data_[j] = sv (j, seq);
 			++j;
 		} while(j<24);
-		data_[j] = score_vector<_score> (j, seq);
+		data_[j] = sv (j, seq);
 		assert(j+1 == Value_traits<_val>::ALPHABET_SIZE);
 	}
 
 	template<typename _val>
-	inline const score_vector<_score>& get(_val i) const
+	inline const sv& get(_val i) const
 	{ return data_[(int)i]; }
 
-	score_vector<_score> data_[25];
+	sv data_[25];
 
 };
 
-#endif /* SCORE_PROFILE_H_ */
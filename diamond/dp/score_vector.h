@@ -25,6 +25,21 @@ Author: Benjamin Buchfink
 #include <tmmintrin.h>
 #endif
 
+/* The 256 and 512 bit kernels are compiled for their instruction set with target
+   pragmas, so they are available to a generic build and selected at runtime. */
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 5
+#define DP_TARGET_PRAGMA
+#endif
+#if defined(__AVX2__) || defined(DP_TARGET_PRAGMA)
+#define DP_AVX2
+#endif
+#if defined(__AVX512BW__) || defined(DP_TARGET_PRAGMA)
+#define DP_AVX512BW
+#endif
+#if defined(DP_AVX2) || defined(DP_AVX512BW)
+#include <immintrin.h>
+#endif
+
 template<typename _score>
 struct score_traits
 {
@@ -37,18 +52,48 @@ template<>
 struct score_traits<uint8_t>
 {
 	//static const unsigned channels = 16;
-	enum { channels = 16, zero = 0x00, byte_size = 1 };
+	enum { channels = 16, zero = 0x00, byte_size = 1, max_score = 0xff };
 	typedef uint16_t Mask;
 };
 
-template<typename _score>
+template<>
+struct score_traits<int16_t>
+{
+	enum { channels = 8, zero = 0x0000, byte_size = 2, max_score = 0x7fff };
+	typedef uint16_t Mask;
+};
+
+template<unsigned _bits>
+struct simd_vector
+{ };
+
+template<>
+struct simd_vector<128>
+{ typedef __m128i Type; };
+
+#ifdef DP_AVX2
+template<>
+struct simd_vector<256>
+{ typedef __m256i Type; };
+#endif
+
+#ifdef DP_AVX512BW
+template<>
+struct simd_vector<512>
+{ typedef __m512i Type; };
+#endif
+
+template<typename _score, unsigned _bits = 128>
 struct score_vector
 { };
 
 template<>
-struct score_vector<uint8_t>
+struct score_vector<uint8_t,128>
 {
 
+	enum { channels = 16 };
+	typedef uint16_t Mask;
+
 	score_vector()
 	{
 		data_ = _mm_set1_epi8(score_traits<uint8_t>::zero);
@@ -174,4 +219,382 @@ struct score_vector<uint8_t>
 
 };
 
+template<>
+struct score_vector<int16_t,128>
+{
+
+	enum { channels = 8 };
+	typedef uint16_t Mask;
+
+	score_vector():
+		data_ (_mm_set1_epi16(score_traits<int16_t>::zero))
+	{ }
+
+	explicit score_vector(int x):
+		data_ (_mm_set1_epi16(x))
+	{ }
+
+	explicit score_vector(__m128i data):
+		data_ (data)
+	{ }
+
+	explicit score_vector(unsigned a, const __m128i &seq)
+	{
+		if(program_options::have_ssse3) {
+#ifdef __SSSE3__
+			set_ssse3(a, seq);
+#else
+			set_generic(a, seq);
+#endif
+		} else
+			set_generic(a, seq);
+	}
+
+	void set_ssse3(unsigned a, const __m128i &seq)
+	{
+#ifdef __SSSE3__
+		const __m128i *row = reinterpret_cast<const __m128i*>(&score_matrix::get().matrix16()[a << 5]);
+
+		// the row holds 4 groups of 8 scores, shuffle the byte pairs within each group and select by group
+		const __m128i idx = _mm_add_epi16(_mm_mullo_epi16(_mm_and_si128(seq, _mm_set1_epi16(7)), _mm_set1_epi16(0x202)), _mm_set1_epi16(0x100));
+		const __m128i group = _mm_srli_epi16(seq, 3);
+		__m128i r = _mm_setzero_si128();
+		for(int k=0;k<4;++k)
+			r = _mm_or_si128(r, _mm_and_si128(_mm_cmpeq_epi16(group, _mm_set1_epi16(k)), _mm_shuffle_epi8(_mm_load_si128(row+k), idx)));
+		data_ = r;
+#endif
+	}
+
+	void set_generic(unsigned a, const __m128i &seq)
+	{
+		// the lanes are copied through memory, int16_t pointers into the vector would break strict aliasing
+		const int16_t* row (&score_matrix::get().matrix16()[a<<5]);
+		int16_t letters[8], scores[8];
+		_mm_storeu_si128((__m128i*)letters, seq);
+		// lanes without a letter score 0, as in set_ssse3
+		for(unsigned i=0;i<8;i++)
+			scores[i] = letters[i] < 0 ? 0 : row[letters[i]];
+		data_ = _mm_loadu_si128((const __m128i*)scores);
+	}
+
+	score_vector operator+(const score_vector &rhs) const
+	{
+		return score_vector (_mm_adds_epi16(data_, rhs.data_));
+	}
+
+	score_vector operator-(const score_vector &rhs) const
+	{
+		return score_vector (_mm_subs_epi16(data_, rhs.data_));
+	}
+
+	score_vector& operator-=(const score_vector &rhs)
+	{
+		data_ = _mm_subs_epi16(data_, rhs.data_);
+		return *this;
+	}
+
+	// the 16 bit scores are not biased, they are only clamped at zero to keep the alignment local
+	void clamp_zero()
+	{ data_ = _mm_max_epi16(data_, _mm_setzero_si128()); }
+
+	int operator [](unsigned i) const
+	{
+		int16_t x[8];
+		_mm_storeu_si128((__m128i*)x, data_);
+		return x[i];
+	}
+
+	void set(unsigned i, int16_t v)
+	{
+		int16_t x[8];
+		_mm_storeu_si128((__m128i*)x, data_);
+		x[i] = v;
+		data_ = _mm_loadu_si128((const __m128i*)x);
+	}
+
+	score_vector& max(const score_vector &rhs)
+	{
+		data_ = _mm_max_epi16(data_, rhs.data_);
+		return *this;
+	}
+
+	score_vector& min(const score_vector &rhs)
+	{
+		data_ = _mm_min_epi16(data_, rhs.data_);
+		return *this;
+	}
+
+	friend score_vector max(const score_vector& lhs, const score_vector &rhs)
+	{
+		return score_vector (_mm_max_epi16(lhs.data_, rhs.data_));
+	}
+
+	friend score_vector min(const score_vector& lhs, const score_vector &rhs)
+	{
+		return score_vector (_mm_min_epi16(lhs.data_, rhs.data_));
+	}
+
+	uint16_t cmpeq(const score_vector &rhs) const
+	{
+		return _mm_movemask_epi8(_mm_cmpeq_epi16(data_, rhs.data_));
+	}
+
+	__m128i cmpeq2(const score_vector &rhs) const
+	{
+		return _mm_cmpeq_epi16(data_, rhs.data_);
+	}
+
+	uint16_t cmpgt(const score_vector &rhs) const
+	{
+		return _mm_movemask_epi8(_mm_cmpgt_epi16(data_, rhs.data_));
+	}
+
+	__m128i data_;
+
+};
+
+#ifdef DP_AVX2
+
+#ifdef DP_TARGET_PRAGMA
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+template<>
+struct score_vector<uint8_t,256>
+{
+
+	enum { channels = 32 };
+	typedef uint32_t Mask;
+
+	score_vector():
+		data_ (_mm256_set1_epi8(score_traits<uint8_t>::zero))
+	{ }
+
+	explicit score_vector(int x):
+		data_ (_mm256_set1_epi8(x))
+	{ }
+
+	explicit score_vector(__m256i data):
+		data_ (data)
+	{ }
+
+	explicit score_vector(unsigned a, const __m256i &seq)
+	{
+		const __m128i *row = reinterpret_cast<const __m128i*>(&score_matrix::get().matrix8u()[a << 5]);
+
+		__m256i high_mask = _mm256_slli_epi16(_mm256_and_si256(seq, _mm256_set1_epi8(0x10)), 3);
+		__m256i seq_low = _mm256_or_si256(seq, high_mask);
+		__m256i seq_high = _mm256_or_si256(seq, _mm256_xor_si256(high_mask, _mm256_set1_epi8(0x80)));
+
+		// the shuffle works within 128 bit lanes, so each half of the row is broadcast to both lanes
+		__m256i r1 = _mm256_broadcastsi128_si256(_mm_load_si128(row));
+		__m256i r2 = _mm256_broadcastsi128_si256(_mm_load_si128(row+1));
+		__m256i s1 = _mm256_shuffle_epi8(r1, seq_low);
+		__m256i s2 = _mm256_shuffle_epi8(r2, seq_high);
+		data_ = _mm256_or_si256(s1, s2);
+	}
+
+	score_vector(const uint8_t* s):
+		data_ (_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s)))
+	{ }
+
+	score_vector operator+(const score_vector &rhs) const
+	{
+		return score_vector (_mm256_adds_epu8(data_, rhs.data_));
+	}
+
+	score_vector operator-(const score_vector &rhs) const
+	{
+		return score_vector (_mm256_subs_epu8(data_, rhs.data_));
+	}
+
+	score_vector& operator-=(const score_vector &rhs)
+	{
+		data_ = _mm256_subs_epu8(data_, rhs.data_);
+		return *this;
+	}
+
+	void unbias(const score_vector &bias)
+	{ this->operator -=(bias); }
+
+	int operator [](unsigned i) const
+	{
+		return *(((uint8_t*)&data_)+i);
+	}
+
+	void set(unsigned i, uint8_t v)
+	{
+		*(((uint8_t*)&data_)+i) = v;
+	}
+
+	score_vector& max(const score_vector &rhs)
+	{
+		data_ = _mm256_max_epu8(data_, rhs.data_);
+		return *this;
+	}
+
+	score_vector& min(const score_vector &rhs)
+	{
+		data_ = _mm256_min_epu8(data_, rhs.data_);
+		return *this;
+	}
+
+	friend score_vector max(const score_vector& lhs, const score_vector &rhs)
+	{
+		return score_vector (_mm256_max_epu8(lhs.data_, rhs.data_));
+	}
+
+	friend score_vector min(const score_vector& lhs, const score_vector &rhs)
+	{
+		return score_vector (_mm256_min_epu8(lhs.data_, rhs.data_));
+	}
+
+	uint32_t cmpeq(const score_vector &rhs) const
+	{
+		return _mm256_movemask_epi8(_mm256_cmpeq_epi8(data_, rhs.data_));
+	}
+
+	__m256i cmpeq2(const score_vector &rhs) const
+	{
+		return _mm256_cmpeq_epi8(data_, rhs.data_);
+	}
+
+	uint32_t cmpgt(const score_vector &rhs) const
+	{
+		return _mm256_movemask_epi8(_mm256_cmpgt_epi8(data_, rhs.data_));
+	}
+
+	__m256i data_;
+
+};
+
+#ifdef DP_TARGET_PRAGMA
+#pragma GCC pop_options
+#endif
+
+#endif
+
+#ifdef DP_AVX512BW
+
+#ifdef DP_TARGET_PRAGMA
+#pragma GCC push_options
+#pragma GCC target("avx512bw")
+#endif
+
+template<>
+struct score_vector<uint8_t,512>
+{
+
+	enum { channels = 64 };
+	typedef uint64_t Mask;
+
+	score_vector():
+		data_ (_mm512_set1_epi8(score_traits<uint8_t>::zero))
+	{ }
+
+	explicit score_vector(int x):
+		data_ (_mm512_set1_epi8(x))
+	{ }
+
+	explicit score_vector(__m512i data):
+		data_ (data)
+	{ }
+
+	explicit score_vector(unsigned a, const __m512i &seq)
+	{
+		const __m128i *row = reinterpret_cast<const __m128i*>(&score_matrix::get().matrix8u()[a << 5]);
+
+		__m512i high_mask = _mm512_slli_epi16(_mm512_and_si512(seq, _mm512_set1_epi8(0x10)), 3);
+		__m512i seq_low = _mm512_or_si512(seq, high_mask);
+		__m512i seq_high = _mm512_or_si512(seq, _mm512_xor_si512(high_mask, _mm512_set1_epi8(0x80)));
+
+		// the zero masked broadcast avoids the undefined source operand of the plain one
+		__m512i r1 = _mm512_maskz_broadcast_i32x4(0xffff, _mm_load_si128(row));
+		__m512i r2 = _mm512_maskz_broadcast_i32x4(0xffff, _mm_load_si128(row+1));
+		__m512i s1 = _mm512_shuffle_epi8(r1, seq_low);
+		__m512i s2 = _mm512_shuffle_epi8(r2, seq_high);
+		data_ = _mm512_or_si512(s1, s2);
+	}
+
+	score_vector(const uint8_t* s):
+		data_ (_mm512_loadu_si512(reinterpret_cast<const void*>(s)))
+	{ }
+
+	score_vector operator+(const score_vector &rhs) const
+	{
+		return score_vector (_mm512_adds_epu8(data_, rhs.data_));
+	}
+
+	score_vector operator-(const score_vector &rhs) const
+	{
+		return score_vector (_mm512_subs_epu8(data_, rhs.data_));
+	}
+
+	score_vector& operator-=(const score_vector &rhs)
+	{
+		data_ = _mm512_subs_epu8(data_, rhs.data_);
+		return *this;
+	}
+
+	void unbias(const score_vector &bias)
+	{ this->operator -=(bias); }
+
+	int operator [](unsigned i) const
+	{
+		return *(((uint8_t*)&data_)+i);
+	}
+
+	void set(unsigned i, uint8_t v)
+	{
+		*(((uint8_t*)&data_)+i) = v;
+	}
+
+	score_vector& max(const score_vector &rhs)
+	{
+		data_ = _mm512_max_epu8(data_, rhs.data_);
+		return *this;
+	}
+
+	score_vector& min(const score_vector &rhs)
+	{
+		data_ = _mm512_min_epu8(data_, rhs.data_);
+		return *this;
+	}
+
+	friend score_vector max(const score_vector& lhs, const score_vector &rhs)
+	{
+		return score_vector (_mm512_max_epu8(lhs.data_, rhs.data_));
+	}
+
+	friend score_vector min(const score_vector& lhs, const score_vector &rhs)
+	{
+		return score_vector (_mm512_min_epu8(lhs.data_, rhs.data_));
+	}
+
+	uint64_t cmpeq(const score_vector &rhs) const
+	{
+		return _mm512_cmpeq_epi8_mask(data_, rhs.data_);
+	}
+
+	__m512i cmpeq2(const score_vector &rhs) const
+	{
+		return _mm512_movm_epi8(_mm512_cmpeq_epi8_mask(data_, rhs.data_));
+	}
+
+	uint64_t cmpgt(const score_vector &rhs) const
+	{
+		return _mm512_cmpgt_epi8_mask(data_, rhs.data_);
+	}
+
+	__m512i data_;
+
+};
+
+#ifdef DP_TARGET_PRAGMA
+#pragma GCC pop_options
+#endif
+
+#endif
+
 #endif /* SCORE_VECTOR_H_ */
@@ -21,30 +21,61 @@ Author: Benjamin Buchfink
 #ifndef SSE_SW_H_
 #define SSE_SW_H_
 
-#include "score_profile.h"
-#include "dp_matrix.h"
+#include <vector>
+#include <algorithm>
+#include <boost/thread/tss.hpp>
+#include "../basic/sequence.h"
+#include "score_vector.h"
+
+namespace sw_sse {
+#include "sw_kernel.h"
+}
 
-template<typename _score>
-inline score_vector<_score> cell_update(const score_vector<_score> &diagonal_cell,
-						 const score_vector<_score> &scores,
-						 const score_vector<_score> &gap_extension,
-						 const score_vector<_score> &gap_open,
-						 score_vector<_score> &horizontal_gap,
-						 score_vector<_score> &vertical_gap,
-						 score_vector<_score> &best,
-						 const score_vector<_score> &vbias)
-{
-	score_vector<_score> current_cell = diagonal_cell + scores;
-	current_cell.unbias(vbias);
-	current_cell.max(vertical_gap).max(horizontal_gap);
-	best.max(current_cell);
-	vertical_gap -= gap_extension;
-	horizontal_gap -=  gap_extension;
-	score_vector<_score> open = current_cell - gap_open;
-	vertical_gap.max(open);
-	horizontal_gap.max(open);
-	return current_cell;
+#ifdef DP_AVX2
+#ifdef DP_TARGET_PRAGMA
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+namespace sw_avx2 {
+#include "sw_kernel.h"
 }
+#ifdef DP_TARGET_PRAGMA
+#pragma GCC pop_options
+#endif
+#endif
+
+#ifdef DP_AVX512BW
+#ifdef DP_TARGET_PRAGMA
+#pragma GCC push_options
+#pragma GCC target("avx512bw")
+#endif
+namespace sw_avx512bw {
+#include "sw_kernel.h"
+}
+#ifdef DP_TARGET_PRAGMA
+#pragma GCC pop_options
+#endif
+#endif
+
+template<typename _callback>
+struct Overflow_callback
+{
+	Overflow_callback(_callback &f, const vector<unsigned> &idx):
+		f_ (f),
+		idx_ (idx)
+	{ }
+	template<typename _seq>
+	void operator()(int i, const _seq &seq, int score)
+	{ f_(idx_[i], seq, score); }
+	_callback &f_;
+	const vector<unsigned> &idx_;
+};
+
+/* Runs the widest kernel supported by the CPU, unless the subjects fit
+   into fewer channels of a narrower vector. Subjects whose score saturates
+   the 8 bit lanes are recomputed with 16 bit scores. Subjects that saturate
+   those as well are reported with the 16 bit maximum, which lies above any
+   filter score. */
 
 template<typename _val, typename _score, typename _callback>
 void smith_waterman(const sequence<const _val> &query,
@@ -58,63 +89,31 @@ void smith_waterman(const sequence<const _val> &query,
 			const _score&,
 			Statistics &stats)
 {
-	#ifdef SW_ENABLE_DEBUG
-	int v[1024][1024];
-	#endif
-
-	typedef score_vector<_score> sv;
-
-	unsigned qlen (query.length());
-	unsigned slen (subjects[0].length());
-	DP_matrix<_score> dp (slen, qlen, band, padding);
-
-	sv open_penalty (static_cast<char>(op));
-	sv extend_penalty (static_cast<char>(ep));
-	sv vbias (score_matrix::get().bias());
-	sequence_stream dseq;
-	score_profile<_score> profile;
-
-	typename vector<sequence<const _val> >::const_iterator subject_it (subjects.begin());
-	while(subject_it < subjects.end()) {
-
-		const unsigned n_subject (std::min((unsigned)score_traits<_score>::channels, (unsigned)(subjects.end() - subject_it)));
-		typename vector<sequence<const _val> >::const_iterator subject_end (subject_it + n_subject);
-		sv best;
-		dseq.reset();
-		dp.clear();
-
-		for(unsigned j=0;j<slen;++j) {
-			typename DP_matrix<_score>::Column_iterator it (dp.begin(j));
-			sv vgap, hgap, column_best;
-			profile.template set<_val> (dseq.get<_val>(subject_it, subject_end, j, _score()));
-
-			while(!it.at_end()) {
-				hgap = it.hgap();
-				sv next = cell_update<_score>(it.diag(), profile.get(query[it.row_pos_]), extend_penalty, open_penalty, hgap, vgap, column_best, vbias);
-				it.set_hgap(hgap);
-				it.set_score(next);
-				#ifdef SW_ENABLE_DEBUG
-				v[j][it.row_pos_] = next[0];
-				#endif
-				++it;
-			}
-			best.max(column_best);
-		}
-
-		for(unsigned i=0;i<n_subject;++i)
-			if(best[i] >= filter_score)
-				f(i + (subject_it - subjects.begin()), *(subject_it + i), best[i]);
-		subject_it += score_traits<_score>::channels;
-	}
-
-	#ifdef SW_ENABLE_DEBUG
-	for(unsigned j=0;j<qlen;++j) {
-		for(unsigned i=0;i<subjects[0].length();++i)
-			printf("%4i", v[i][j]);
-		printf("\n");
-	}
-	printf("\n");
-	#endif
+	vector<unsigned> overflow;
+#ifdef DP_AVX512BW
+	if(program_options::have_avx512bw && subjects.size() > 32)
+		sw_avx512bw::smith_waterman<_val,_score,512>(query, subjects, band, padding, op, ep, filter_score, f, overflow, stats);
+	else
+#endif
+#ifdef DP_AVX2
+	if(program_options::have_avx2 && subjects.size() > 16)
+		sw_avx2::smith_waterman<_val,_score,256>(query, subjects, band, padding, op, ep, filter_score, f, overflow, stats);
+	else
+#endif
+		sw_sse::smith_waterman<_val,_score,128>(query, subjects, band, padding, op, ep, filter_score, f, overflow, stats);
+
+	if(overflow.empty())
+		return;
+	vector<sequence<const _val> > retry;
+	for(vector<unsigned>::const_iterator i=overflow.begin();i!=overflow.end();++i)
+		retry.push_back(subjects[*i]);
+	Overflow_callback<_callback> g (f, overflow);
+	vector<unsigned> overflow16;
+	sw_sse::smith_waterman<_val,int16_t,128>(query, retry, band, padding, op, ep, filter_score, g, overflow16, stats);
+	for(vector<unsigned>::const_iterator i=overflow16.begin();i!=overflow16.end();++i)
+		g(*i, retry[*i], score_traits<int16_t>::max_score);
+	stats.inc(Statistics::SW_OVERFLOW, overflow.size());
+	stats.inc(Statistics::SW_OVERFLOW16, overflow16.size());
 }
 
 #endif /* SSE_SW_H_ */
@@ -0,0 +1,134 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+/* The banded SIMD Smith-Waterman kernel. There is no include guard, smith_waterman.h
+   includes this file once per instruction set into its own namespace, with the
+   target options of that instruction set in effect. */
+
+#include "dp_matrix.h"
+#include "score_profile.h"
+
+/* Takes a cell back to the local floor. The 8 bit scores subtract the bias of
+   the profile with saturation at zero, the unbiased 16 bit scores are only
+   clamped at zero. */
+template<typename _sv>
+inline void local_floor(_sv &v, const _sv &bias)
+{ v.unbias(bias); }
+
+inline void local_floor(score_vector<int16_t,128> &v, const score_vector<int16_t,128>&)
+{ v.clamp_zero(); }
+
+template<typename _sv>
+inline _sv cell_update(const _sv &diagonal_cell,
+						 const _sv &scores,
+						 const _sv &gap_extension,
+						 const _sv &gap_open,
+						 _sv &horizontal_gap,
+						 _sv &vertical_gap,
+						 _sv &best,
+						 const _sv &vbias)
+{
+	_sv current_cell = diagonal_cell + scores;
+	local_floor(current_cell, vbias);
+	current_cell.max(vertical_gap).max(horizontal_gap);
+	best.max(current_cell);
+	vertical_gap -= gap_extension;
+	horizontal_gap -=  gap_extension;
+	_sv open = current_cell - gap_open;
+	vertical_gap.max(open);
+	horizontal_gap.max(open);
+	return current_cell;
+}
+
+template<typename _val, typename _score, unsigned _bits, typename _callback>
+void smith_waterman(const sequence<const _val> &query,
+			const vector<sequence<const _val> > &subjects,
+			unsigned band,
+			unsigned padding,
+			int op,
+			int ep,
+			int filter_score,
+			_callback &f,
+			vector<unsigned> &overflow,
+			Statistics &stats)
+{
+	#ifdef SW_ENABLE_DEBUG
+	int v[1024][1024];
+	#endif
+
+	typedef score_vector<_score,_bits> sv;
+
+	unsigned qlen (query.length());
+	unsigned slen (subjects[0].length());
+	DP_matrix<_score,_bits> dp (slen, qlen, band, padding);
+
+	sv open_penalty (static_cast<char>(op));
+	sv extend_penalty (static_cast<char>(ep));
+	sv vbias (score_matrix::get().bias());
+	// a lane that reached the maximum before the bias was subtracted
+	sv saturated (score_traits<_score>::max_score);
+	local_floor(saturated, vbias);
+	sequence_stream<_bits> dseq;
+	score_profile<_score,_bits> profile;
+
+	typename vector<sequence<const _val> >::const_iterator subject_it (subjects.begin());
+	while(subject_it < subjects.end()) {
+
+		const unsigned n_subject (std::min((unsigned)sv::channels, (unsigned)(subjects.end() - subject_it)));
+		typename vector<sequence<const _val> >::const_iterator subject_end (subject_it + n_subject);
+		sv best;
+		dseq.reset();
+		dp.clear();
+
+		for(unsigned j=0;j<slen;++j) {
+			typename DP_matrix<_score,_bits>::Column_iterator it (dp.begin(j));
+			sv vgap, hgap, column_best;
+			profile.template set<_val> (dseq.template get<_val>(subject_it, subject_end, j, _score()));
+
+			while(!it.at_end()) {
+				hgap = it.hgap();
+				sv next = cell_update<sv>(it.diag(), profile.get(query[it.row_pos_]), extend_penalty, open_penalty, hgap, vgap, column_best, vbias);
+				it.set_hgap(hgap);
+				it.set_score(next);
+				#ifdef SW_ENABLE_DEBUG
+				v[j][it.row_pos_] = next[0];
+				#endif
+				++it;
+			}
+			best.max(column_best);
+		}
+
+		for(unsigned i=0;i<n_subject;++i)
+			if(best[i] >= saturated[0])
+				overflow.push_back(i + (subject_it - subjects.begin()));
+			else if(best[i] >= filter_score)
+				f(i + (subject_it - subjects.begin()), *(subject_it + i), best[i]);
+		subject_it += sv::channels;
+	}
+
+	#ifdef SW_ENABLE_DEBUG
+	for(unsigned j=0;j<qlen;++j) {
+		for(unsigned i=0;i<subjects[0].length();++i)
+			printf("%4i", v[i][j]);
+		printf("\n");
+	}
+	printf("\n");
+	#endif
+}
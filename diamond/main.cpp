@@ -28,6 +28,7 @@ Author: Benjamin Buchfink
 #include "run/master_thread.h"
 #include "util/complexity_filter.h"
 #include "basic/setup.h"
+#include "test/tests.h"
 
 #ifdef EXTRA
 #include "../extra/test_sw.h"
@@ -65,6 +66,7 @@ int main(int ac, const char* av[])
         makedb.add_options()
         	("in", po::value<string>(&program_options::input_ref_file), "input reference file in FASTA format")
         	("block-size,b", po::value<double>(&program_options::chunk_size), "sequence block size in billions of letters (default=2)")
+        	("seed-index", "precompute the reference seed index for the selected sensitivity mode")
 #ifdef EXTRA
         	("dbtype", po::value<string>(&program_options::db_type), "database type (nucl/prot)")
 #endif
@@ -111,8 +113,13 @@ int main(int ac, const char* av[])
         	("band", po::value<int>(&program_options::padding)->default_value(0), "band for dynamic programming computation")
         	("shapes,s", po::value<unsigned>(&program_options::shapes)->default_value(0), "number of seed shapes (0 = all available)")
         	("index-mode", po::value<unsigned>(&program_options::index_mode)->default_value(0), "index mode (1=4x12, 2=16x9)")
+        	("query-cache", po::value<double>(&program_options::query_cache)->default_value(0), "memory for keeping the query index across reference blocks in GB, larger indexes are spilled to tmpdir (0=block size)")
+        	("bins", po::value<unsigned>(&program_options::trace_pt_bins)->default_value(0), "number of query bins for seed hits")
+        	("bin-mem", po::value<double>(&program_options::bin_mem)->default_value(0), "memory target in GB for the seed hits of one bin, sets the number of bins from the previous reference block (0=4 bins, 1 in /dev/shm)")
         	("no-traceback,r", "disable alignment traceback")
-        	("compress-temp", po::value<unsigned>(&program_options::compress_temp)->default_value(0), "compression for temporary output files (0=none, 1=gzip)");
+        	("compress-temp", po::value<unsigned>(&program_options::compress_temp)->default_value(0), "compression for temporary output files (0=none, 1=gzip)")
+        	("prefetch-mem", po::value<double>(&program_options::prefetch_mem)->default_value(0), "memory limit in GB shared by the current and prefetched reference blocks and query chunks (0=no limit)")
+        	("mmap-db", "memory-map the database file instead of reading it into memory");
 
         po::options_description hidden("Hidden options");
         hidden.add_options()
@@ -142,6 +149,8 @@ int main(int ac, const char* av[])
         program_options::verbose = vm.count("verbose") > 0;
         program_options::debug_log = vm.count("log") > 0;
         program_options::salltitles = vm.count("salltitles") > 0;
+        program_options::mmap_db = vm.count("mmap-db") > 0;
+        program_options::seed_index = vm.count("seed-index") > 0;
 
         setup(command, ac, av);
 
@@ -175,6 +184,12 @@ int main(int ac, const char* av[])
         		program_options::chunk_size = 0;
         	master_thread<Amino_acid>();
         }
+        else if (command == "check") {
+        	if(!run_tests())
+        		return 1;
+        }
+        else if (command == "benchmark")
+        	run_benchmarks();
 		#ifdef ENABLE_STAT
         //else if (command == "stat" && vm.count("match1"))
         	//blast_stat(vm.count("tab") > 0);
@@ -24,6 +24,7 @@ Author: Benjamin Buchfink
 #include <iostream>
 #include "../basic/options.h"
 #include "../data/reference.h"
+#include "../data/seed_index.h"
 #include "../basic/exceptions.h"
 #include "../basic/statistics.h"
 #include "../data/load_seqs.h"
@@ -39,7 +40,7 @@ void make_db(_val)
 
 	boost::timer::cpu_timer total;
 	task_timer timer ("Opening the database file", true);
-	Input_stream db_file (program_options::input_ref_file, true);
+	Input_buffer db_file (program_options::input_ref_file, true);
 	timer.finish();
 
 	ref_header.block_size = program_options::chunk_size;
@@ -47,6 +48,13 @@ void make_db(_val)
 	Output_stream main(program_options::database_file_name());
 	main.write(&ref_header, 1);
 
+	auto_ptr<Seed_index_writer> index;
+	if(program_options::seed_index) {
+		program_options::set_options<_val>(ref_header.block_size);
+		shape_config::instance = shape_config (program_options::index_mode, _val());
+		index = auto_ptr<Seed_index_writer> (new Seed_index_writer ());
+	}
+
 	for(;;++chunk) {
 		timer.go("Loading sequences");
 		size_t n_seq = load_seqs<_val,_val>(db_file, FASTA_format<_val> (), ref_seqs<_val>::data_, ref_ids::data_, (size_t)(program_options::chunk_size * 1e9));
@@ -60,6 +68,7 @@ void make_db(_val)
 		ref_seqs<_val>::data_->print_stats();
 
 		timer.go("Building histograms");
+		ref_seqs<_val>::data_->build_reduced();
 		seed_histogram *hst = new seed_histogram (*ref_seqs<_val>::data_, _val());
 
 		timer.go("Saving to disk");
@@ -67,6 +76,11 @@ void make_db(_val)
 		ref_ids::get().save(main);
 		main.write(hst, 1);
 
+		if(index.get()) {
+			timer.go("Building seed index");
+			index->write_block(*ref_seqs<_val>::data_, *hst, long_addressing);
+		}
+
 		timer.go("Deallocating sequences");
 		delete ref_seqs<_val>::data_;
 		delete ref_ids::data_;
@@ -78,6 +92,8 @@ void make_db(_val)
 	main.seekp(0);
 	main.write(&ref_header, 1);
 	main.close();
+	if(index.get())
+		index->close();
 
 	verbose_stream << "Total time = " << boost::timer::format(total.elapsed(), 1, "%ws\n");
 }
@@ -24,12 +24,14 @@ Author: Benjamin Buchfink
 #include <iostream>
 #include <boost/timer/timer.hpp>
 #include "../data/reference.h"
+#include "../data/seed_index.h"
+#include "../data/index_cache.h"
 #include "../data/queries.h"
 #include "../basic/statistics.h"
 #include "../basic/shape_config.h"
 #include "../output/join_blocks.h"
 #include "../align/align_queries.h"
-#include "../search/align_range.h"
+#include "../search/partition_tasks.h"
 #include "../basic/setup.h"
 
 using std::endl;
@@ -44,7 +46,8 @@ void process_shape(unsigned sid,
 		unsigned query_chunk,
 		unsigned ref_chunk,
 		char *query_buffer,
-		char *ref_buffer)
+		char *ref_buffer,
+		Index_cache<_locq> &query_cache)
 {
 	using std::vector;
 	using boost::atomic;
@@ -56,64 +59,49 @@ void process_shape(unsigned sid,
 		const seedp_range range (p.getMin(chunk), p.getMax(chunk));
 		current_range = range;
 
-		task_timer timer ("Building reference index", true);
-		typename sorted_list<_locr>::Type ref_idx (ref_buffer,
-				*ref_seqs<_val>::data_,
-				shape_config::instance.get_shape(sid),
-				ref_hst.get(program_options::index_mode, sid),
-				range);
+		task_timer timer (ref_seed_index.get() ? "Loading reference index" : "Building reference index", true);
+		const shape_histogram &hst = ref_hst->get(program_options::index_mode, sid);
+		typename sorted_list<_locr>::Type ref_idx (ref_seed_index.get()
+				? typename sorted_list<_locr>::Type (ref_seed_index->template get<_locr>(ref_chunk, sid, hst, range, ref_buffer), hst, range)
+				: typename sorted_list<_locr>::Type (ref_buffer, *ref_seqs<_val>::data_, shape_config::instance.get_shape(sid), hst, range));
 		ref_masking.build<_val,_locr>(sid, range, ref_idx);
 
-		timer.go("Building query index");
+		timer.go(query_cache.contains(sid, chunk) ? "Loading query index" : "Building query index");
 		timer_mapping.resume();
-		typename sorted_list<_locq>::Type query_idx (query_buffer,
-				*query_seqs<_val>::data_,
-				shape_config::instance.get_shape(sid),
-				query_hst->get(program_options::index_mode, sid),
-				range);
+		const shape_histogram &qhst = query_hst->get(program_options::index_mode, sid);
+		typename sorted_list<_locq>::Type query_idx (query_cache.contains(sid, chunk)
+				? typename sorted_list<_locq>::Type (query_cache.get(sid, chunk, query_buffer), qhst, range)
+				: typename sorted_list<_locq>::Type (query_buffer, *query_seqs<_val>::data_, shape_config::instance.get_shape(sid), qhst, range));
+		query_cache.put(sid, chunk, query_idx);
 		timer.finish();
 
 		timer.go("Searching alignments");
-#pragma omp parallel
-		{
-			Statistics stat;
-#pragma omp for schedule(dynamic) nowait
-			for(unsigned seedp=0;seedp<Const::seedp;++seedp) {
-				try {
-					align_partition<_val,_locr,_locq,_locl>(seedp,
-							stat,
-							sid,
-							ref_idx.get_partition_cbegin(seedp),
-							query_idx.get_partition_cbegin(seedp));
-				} catch (std::exception &e) {
-					exception_state.set(e);
-				}
-			}
-#pragma omp critical
-			statistics += stat;
-		}
+		search_partitions<_val,_locr,_locq,_locl>(sid, ref_idx, query_idx);
 
+		if(ref_seed_index.get())
+			ref_seed_index->release(ref_idx.data(), ref_idx.size() * sizeof(typename sorted_list<_locr>::Type::entry));
 	}
 	timer_mapping.stop();
 }
 
 template<typename _val, typename _locr, typename _locq, typename _locl>
-void run_ref_chunk(Database_file &db_file,
+void run_ref_chunk(Reference_loader<_val> &ref_loader,
 		cpu_timer &timer_mapping,
 		cpu_timer &total_timer,
 		unsigned query_chunk,
 		unsigned ref_chunk,
 		pair<size_t,size_t> query_len_bounds,
-		char *query_buffer)
+		char *query_buffer,
+		Index_cache<_locq> &query_cache)
 {
 	task_timer timer ("Loading reference sequences", true);
-	ref_seqs<_val>::data_ = new Sequence_set<_val> (db_file);
-	ref_ids::data_ = new String_set<char,0> (db_file);
-	db_file.read(&ref_hst, 1);
+	ref_loader.next();
+	if(ref_chunk+1 < ref_header.n_blocks && !ref_loader.prefetch())
+		log_stream << "Reference block prefetching disabled by memory limit." << endl;
 	setup_search_params(query_len_bounds, ref_seqs<_val>::data_->letters());
 
 	timer.go("Allocating buffers");
-	char *ref_buffer = sorted_list<_locr>::Type::alloc_buffer(ref_hst);
+	char *ref_buffer = sorted_list<_locr>::Type::alloc_buffer(*ref_hst);
 
 	timer.go("Initializing temporary storage");
 	timer_mapping.resume();
@@ -124,7 +112,7 @@ void run_ref_chunk(Database_file &db_file,
 	timer_mapping.stop();
 
 	for(unsigned i=0;i<shape_config::instance.count();++i)
-		process_shape<_val,_locr,_locq,_locl>(i, timer_mapping, query_chunk, ref_chunk, query_buffer, ref_buffer);
+		process_shape<_val,_locr,_locq,_locl>(i, timer_mapping, query_chunk, ref_chunk, query_buffer, ref_buffer, query_cache);
 
 	timer.go("Closing temporary storage");
 	Trace_pt_buffer<_locr,_locl>::instance->close();
@@ -172,11 +160,17 @@ void run_query_chunk(Database_file &db_file,
 {
 	task_timer timer ("Allocating buffers", true);
 	char *query_buffer = sorted_list<_locq>::Type::alloc_buffer(*query_hst);
+	Index_cache<_locq> query_cache (ref_header.n_blocks > 1,
+			shape_config::get().count(),
+			::partition (Const::seedp, program_options::lowmem).parts,
+			(size_t)((program_options::query_cache == 0 ? program_options::chunk_size : program_options::query_cache) * 1e9),
+			program_options::tmpdir);
 	timer.finish();
 
 	db_file.rewind();
+	Reference_loader<_val> ref_loader (db_file);
 	for(unsigned ref_chunk=0;ref_chunk<ref_header.n_blocks;++ref_chunk)
-		run_ref_chunk<_val,_locr,_locq,_locl>(db_file, timer_mapping, total_timer, query_chunk, ref_chunk, query_len_bounds, query_buffer);
+		run_ref_chunk<_val,_locr,_locq,_locl>(ref_loader, timer_mapping, total_timer, query_chunk, ref_chunk, query_len_bounds, query_buffer, query_cache);
 
 	timer.go("Deallocating buffers");
 	timer_mapping.resume();
@@ -197,12 +191,14 @@ template<typename _val, typename _locr>
 void master_thread(Database_file &db_file, cpu_timer &timer_mapping, cpu_timer &total_timer)
 {
 	shape_config::instance = shape_config (program_options::index_mode, Amino_acid());
+	ref_seed_index = auto_ptr<Seed_index> (Seed_index::open(sizeof(typename sorted_list<_locr>::Type::entry)));
 
 	task_timer timer ("Opening the input file", true);
 	timer_mapping.resume();
 	const Sequence_file_format<Nucleotide> *format_n (guess_format<Nucleotide>(program_options::query_file));
 	const Sequence_file_format<Amino_acid> *format_a (guess_format<Amino_acid>(program_options::query_file));
-	Input_stream query_file (program_options::query_file, true);
+	Input_buffer query_file (program_options::query_file, true);
+	Query_loader<_val> query_loader (query_file, *format_n, *format_a);
 	current_query_chunk=0;
 
 	timer.go("Opening the output files");
@@ -214,26 +210,14 @@ void master_thread(Database_file &db_file, cpu_timer &timer_mapping, cpu_timer &
 	for(;;++current_query_chunk) {
 		task_timer timer ("Loading query sequences", true);
 		timer_mapping.resume();
-		size_t n_query_seqs;
-		if(input_sequence_type() == nucleotide)
-			n_query_seqs = load_seqs<Nucleotide,_val>(query_file, *format_n, query_seqs<_val>::data_, query_ids::data_, (size_t)(program_options::chunk_size * 1e9));
-		else
-			n_query_seqs = load_seqs<Amino_acid,_val>(query_file, *format_a, query_seqs<_val>::data_, query_ids::data_, (size_t)(program_options::chunk_size * 1e9));
-		if(n_query_seqs == 0)
+		if(query_loader.next() == 0)
 			break;
 		timer.finish();
 		query_seqs<_val>::data_->print_stats();
-
-		if(program_options::seg == "yes") {
-			timer.go("Running complexity filter");
-			Complexity_filter<_val>::get().run(*query_seqs<_val>::data_);
-		}
-
-		timer.go("Building query histograms");
-		query_hst = auto_ptr<seed_histogram> (new seed_histogram (*query_seqs<_val>::data_, _val()));
 		const pair<size_t,size_t> query_len_bounds = query_seqs<_val>::data_->len_bounds(shape_config::get().get_shape(0).length_);
+		if(!query_loader.prefetch())
+			log_stream << "Query chunk prefetching disabled by memory limit." << endl;
 		timer_mapping.stop();
-		timer.finish();
 		const bool long_addressing_query = query_seqs<_val>::data_->raw_len() > (size_t)std::numeric_limits<uint32_t>::max();
 
 		if(query_len_bounds.second <= (size_t)std::numeric_limits<uint8_t>::max()) {
@@ -31,12 +31,10 @@ Author: Benjamin Buchfink
 #include "../search/align_ungapped.h"
 
 template<typename _val, typename _locr, typename _locq, typename _locl>
-void align(const _locq q_pos,
-	  const _val *query,
+void align(const _val *query,
 	  _locr s,
 	  Statistics &stats,
-	  const unsigned sid,
-	  hit_filter<_val,_locr,_locq,_locl> &hf)
+	  Ungapped_batch<_val,_locr> &batch)
 {
 	stats.inc(Statistics::TENTATIVE_MATCHES0);
 	const _val* subject = ref_seqs<_val>::data_->data(s);
@@ -44,18 +42,28 @@ void align(const _locq q_pos,
 	if(fast_match(query, subject) < program_options::min_identities)
 		return;
 
-	stats.inc(Statistics::TENTATIVE_MATCHES1);
-
-	unsigned delta, len;
-	int score;
-	if((score = xdrop_ungapped<_val,_locr,_locq>(query, subject, shape_config::get().get_shape(sid).length_, delta, len)) < program_options::min_ungapped_raw_score)
-		return;
+	batch.push(s, subject);
+}
 
-	if(!is_primary_hit<_val,_locr>(query-delta, subject-delta, delta, sid, len))
-		return;
+template<typename _val, typename _locr, typename _locq, typename _locl>
+void align_batch(const _val *query,
+	  Ungapped_batch<_val,_locr> &batch,
+	  Statistics &stats,
+	  const unsigned sid,
+	  hit_filter<_val,_locr,_locq,_locl> &hf)
+{
+	stats.inc(Statistics::TENTATIVE_MATCHES1, batch.size());
+	batch.extend(query, shape_config::get().get_shape(sid).length_);
 
-	stats.inc(Statistics::TENTATIVE_MATCHES2);
-	hf.push(s, score);
+	for(size_t i=0;i<batch.size();++i) {
+		const unsigned delta = batch.delta[i];
+		if(batch.score[i] < program_options::min_ungapped_raw_score
+				|| !is_primary_hit<_val,_locr>(query-delta, batch.subjects[i]-delta, delta, sid, batch.len[i]))
+			continue;
+		stats.inc(Statistics::TENTATIVE_MATCHES2);
+		hf.push(batch.locs[i], batch.score[i]);
+	}
+	batch.clear();
 }
 
 #endif /* ALIGN_H_ */
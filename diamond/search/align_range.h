@@ -35,25 +35,79 @@ void align_range(_locq q_pos,
 
 	const _val* query = query_seqs<_val>::data_->data(q_pos);
 	hit_filter<_val,_locr,_locq,_locl> hf (stats, q_pos, out);
+	Tls<Ungapped_batch<_val,_locr> > batch (Ungapped_batch<_val,_locr>::ptr);
 
 	if(s.n <= program_options::hit_cap) {
 		stats.inc(Statistics::SEED_HITS, s.n);
 		while(i < s.n) {
-			align<_val,_locr,_locq,_locl>(q_pos, query, s[i], stats, sid, hf);
+			align<_val,_locr,_locq,_locl>(query, s[i], stats, *batch);
 			++i;
 		}
 	} else {
 		while(i < s.n && s[i] != 0) {
 			assert(position_filter(s[i], filter_treshold(s.n), s.key()));
-			align<_val,_locr,_locq,_locl>(q_pos, query, s[i], stats, sid, hf);
+			align<_val,_locr,_locq,_locl>(query, s[i], stats, *batch);
 			stats.inc(Statistics::SEED_HITS);
 			++i;
 		}
 	}
 
+	align_batch<_val,_locr,_locq,_locl>(query, *batch, stats, sid, hf);
 	hf.finish();
 }
 
+/* Reference positions of a seed together with their fast_match windows,
+ * copied once so that all query positions of the seed can be streamed
+ * against a contiguous buffer. */
+template<typename _locr>
+struct Seed_tile
+{
+	template<typename _val>
+	void load(const typename sorted_list<_locr>::Type::const_iterator &s)
+	{
+		subjects.clear();
+		if(s.n <= program_options::hit_cap)
+			for(unsigned i=0;i<s.n;++i)
+				subjects.push_back(s[i]);
+		else
+			for(unsigned i=0;i<s.n && s[i] != 0;++i)
+				subjects.push_back(s[i]);
+		if(windows.size() < subjects.size() * match_window_size)
+			windows.resize(subjects.size() * match_window_size);
+		for(unsigned i=0;i<subjects.size();++i)
+			copy_match_window(ref_seqs<_val>::data_->data(subjects[i]), &windows[i*match_window_size]);
+	}
+	vector<_locr> subjects;
+	vector<uint8_t> windows;
+	static boost::thread_specific_ptr<Seed_tile> ptr;
+};
+
+template<typename _locr> boost::thread_specific_ptr<Seed_tile<_locr> > Seed_tile<_locr>::ptr;
+
+template<typename _val, typename _locr, typename _locq, typename _locl, typename _window>
+void align_tile(const typename sorted_list<_locq>::Type::const_iterator &q,
+				const Seed_tile<_locr> &tile,
+				Statistics &stats,
+				typename Trace_pt_buffer<_locr,_locl>::Iterator &out,
+				const unsigned sid)
+{
+	const unsigned n = tile.subjects.size();
+	Tls<Ungapped_batch<_val,_locr> > batch (Ungapped_batch<_val,_locr>::ptr);
+	for(unsigned i=0;i<q.n; ++i) {
+		const _locq q_pos (q[i]);
+		const _val* query = query_seqs<_val>::data_->data(q_pos);
+		const _window match (query);
+		hit_filter<_val,_locr,_locq,_locl> hf (stats, q_pos, out);
+		stats.inc(Statistics::SEED_HITS, n);
+		stats.inc(Statistics::TENTATIVE_MATCHES0, n);
+		for(unsigned j=0;j<n;++j)
+			if(match(&tile.windows[j*match_window_size]) >= program_options::min_identities)
+				batch->push(tile.subjects[j], ref_seqs<_val>::data_->data(tile.subjects[j]));
+		align_batch<_val,_locr,_locq,_locl>(query, *batch, stats, sid, hf);
+		hf.finish();
+	}
+}
+
 template<typename _val, typename _locr, typename _locq, typename _locl>
 void align_range(const typename sorted_list<_locq>::Type::const_iterator &q,
 				 const typename sorted_list<_locr>::Type::const_iterator &s,
@@ -61,13 +115,22 @@ void align_range(const typename sorted_list<_locq>::Type::const_iterator &q,
 				 typename Trace_pt_buffer<_locr,_locl>::Iterator &out,
 				 const unsigned sid)
 {
-	for(unsigned i=0;i<q.n; ++i)
-		align_range<_val,_locr,_locq,_locl>(_locq(q[i]), s, stats, out, sid);
+	if(q.n == 1) {
+		align_range<_val,_locr,_locq,_locl>(_locq(q[0]), s, stats, out, sid);
+		return;
+	}
+	Tls<Seed_tile<_locr> > tile (Seed_tile<_locr>::ptr);
+	tile->template load<_val>(s);
+#ifdef __AVX2__
+	if(program_options::have_avx2)
+		align_tile<_val,_locr,_locq,_locl,Match_window_avx2>(q, *tile, stats, out, sid);
+	else
+#endif
+		align_tile<_val,_locr,_locq,_locl,Match_window>(q, *tile, stats, out, sid);
 }
 
 template<typename _val, typename _locr, typename _locq, typename _locl>
-void align_partition(unsigned hp,
-		Statistics &stats,
+void align_partition(Statistics &stats,
 		unsigned sid,
 		typename sorted_list<_locr>::Type::const_iterator i,
 		typename sorted_list<_locq>::Type::const_iterator j)
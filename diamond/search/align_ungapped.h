@@ -21,6 +21,17 @@ Author: Benjamin Buchfink
 #ifndef ALIGN_UNGAPPED_H_
 #define ALIGN_UNGAPPED_H_
 
+#include <vector>
+#include <boost/thread/tss.hpp>
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+using std::vector;
+
 template<typename _val, typename _locr, typename _locq>
 int xdrop_ungapped(const _val *query, const _val *subject, unsigned seed_len, unsigned &delta, unsigned &len)
 {
@@ -66,4 +77,219 @@ int xdrop_ungapped(const _val *query, const _val *subject, unsigned seed_len, un
 	return score;
 }
 
+#ifdef __SSSE3__
+
+/* Scores of one query letter against the subject letters s[0..15]. The
+ * mask bit of s must be cleared. */
+inline __m128i letter_scores(const int8_t *row, const __m128i &s)
+{
+	const __m128i high_mask = _mm_slli_epi16(_mm_and_si128(s, _mm_set1_epi8(0x10)), 3);
+	const __m128i lo = _mm_shuffle_epi8(_mm_load_si128((const __m128i*)row), _mm_or_si128(s, high_mask));
+	const __m128i hi = _mm_shuffle_epi8(_mm_load_si128((const __m128i*)(row+16)), _mm_or_si128(s, _mm_xor_si128(high_mask, _mm_set1_epi8(0x80))));
+	return _mm_or_si128(lo, hi);
+}
+
+/* 16 bit lanes for the batched ungapped extension, one hit per lane. */
+struct Ungapped_lanes_sse
+{
+	typedef __m128i type;
+	enum { lanes = 8 };
+	static type zero()
+	{ return _mm_setzero_si128(); }
+	static type set(int x)
+	{ return _mm_set1_epi16(x); }
+	static type first(unsigned n)
+	{ return _mm_cmpgt_epi16(_mm_set1_epi16(n), _mm_set_epi16(7,6,5,4,3,2,1,0)); }
+	static type add(const type &a, const type &b)
+	{ return _mm_add_epi16(a, b); }
+	static type sub(const type &a, const type &b)
+	{ return _mm_sub_epi16(a, b); }
+	static type max(const type &a, const type &b)
+	{ return _mm_max_epi16(a, b); }
+	static type cmpgt(const type &a, const type &b)
+	{ return _mm_cmpgt_epi16(a, b); }
+	static type and_(const type &a, const type &b)
+	{ return _mm_and_si128(a, b); }
+	static type andnot(const type &a, const type &b)
+	{ return _mm_andnot_si128(a, b); }
+	static bool any(const type &a)
+	{ return _mm_movemask_epi8(a) != 0; }
+	static unsigned mask(const type &a)
+	{ return _mm_movemask_epi8(_mm_packs_epi16(a, _mm_setzero_si128())); }
+	static type widen(const __m128i &x)
+	{ return _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8); }
+	static void store(int16_t *dst, const type &a)
+	{ _mm_storeu_si128((__m128i*)dst, a); }
+};
+
+#ifdef __AVX2__
+struct Ungapped_lanes_avx2
+{
+	typedef __m256i type;
+	enum { lanes = 16 };
+	static type zero()
+	{ return _mm256_setzero_si256(); }
+	static type set(int x)
+	{ return _mm256_set1_epi16(x); }
+	static type first(unsigned n)
+	{ return _mm256_cmpgt_epi16(_mm256_set1_epi16(n), _mm256_set_epi16(15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,0)); }
+	static type add(const type &a, const type &b)
+	{ return _mm256_add_epi16(a, b); }
+	static type sub(const type &a, const type &b)
+	{ return _mm256_sub_epi16(a, b); }
+	static type max(const type &a, const type &b)
+	{ return _mm256_max_epi16(a, b); }
+	static type cmpgt(const type &a, const type &b)
+	{ return _mm256_cmpgt_epi16(a, b); }
+	static type and_(const type &a, const type &b)
+	{ return _mm256_and_si256(a, b); }
+	static type andnot(const type &a, const type &b)
+	{ return _mm256_andnot_si256(a, b); }
+	static bool any(const type &a)
+	{ return _mm256_movemask_epi8(a) != 0; }
+	static unsigned mask(const type &a)
+	{ return _mm_movemask_epi8(_mm_packs_epi16(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1))); }
+	static type widen(const __m128i &x)
+	{ return _mm256_cvtepi8_epi16(x); }
+	static void store(int16_t *dst, const type &a)
+	{ _mm256_storeu_si256((__m256i*)dst, a); }
+};
+#endif
+
+/* xdrop_ungapped for up to _lanes::lanes subjects against the same query
+ * position. Each lane stops on its own x-drop or padding; the loop ends
+ * when all lanes have stopped. Stopped lanes read the padding letter, so no
+ * subject is read beyond the padding that ends it. */
+
+template<typename _val>
+inline void load_column(uint8_t *col, const _val *const *subjects, unsigned n, int d, unsigned live)
+{
+	for(unsigned i=0;i<n;++i)
+		col[i] = live & (1u << i) ? char(subjects[i][d]) : char(String_set<_val>::PADDING_CHAR);
+}
+
+template<typename _val, typename _lanes>
+void xdrop_ungapped(const _val *query, const _val *const *subjects, unsigned n, unsigned seed_len, int *score_out, unsigned *delta_out, unsigned *len_out)
+{
+	typedef typename _lanes::type type;
+	const int8_t *matrix (score_matrix::get().matrix8());
+	const __m128i pad_char (_mm_set1_epi8(char(String_set<_val>::PADDING_CHAR))), letter_mask (_mm_set1_epi8(0x7F));
+	const type xdrop (_lanes::set(program_options::xdrop)), lanes (_lanes::first(n));
+	uint8_t col[16] __attribute__ ((aligned (16)));
+	memset(col, char(String_set<_val>::PADDING_CHAR), sizeof(col));
+
+	type score (_lanes::zero()), st (_lanes::zero()), delta (_lanes::zero()), active (lanes);
+	unsigned live = _lanes::mask(lanes);
+	const unsigned window_left = std::max(program_options::window, (unsigned)Const::seed_anchor) - Const::seed_anchor;
+	for(int d=-1; unsigned(-d) <= window_left && query[d] != String_set<_val>::PADDING_CHAR; --d) {
+		load_column(col, subjects, n, d, live);
+		const __m128i s (_mm_load_si128((const __m128i*)col));
+		active = _lanes::andnot(_lanes::widen(_mm_cmpeq_epi8(s, pad_char)), _lanes::and_(active, _lanes::cmpgt(xdrop, _lanes::sub(score, st))));
+		if(!_lanes::any(active))
+			break;
+		live = _lanes::mask(active);
+		st = _lanes::add(st, _lanes::and_(_lanes::widen(letter_scores(&matrix[int(char(query[d])) << 5], _mm_and_si128(s, letter_mask))), active));
+		score = _lanes::max(score, st);
+		delta = _lanes::sub(delta, active);
+	}
+
+	assert(seed_len >= Const::seed_anchor);
+	const unsigned window_right = std::max(program_options::window, seed_len - Const::seed_anchor) - (seed_len - Const::seed_anchor);
+	type right (_lanes::zero());
+	st = score;
+	active = lanes;
+	live = _lanes::mask(lanes);
+	for(unsigned d=seed_len; d < seed_len + window_right && query[d] != String_set<_val>::PADDING_CHAR; ++d) {
+		load_column(col, subjects, n, d, live);
+		const __m128i s (_mm_load_si128((const __m128i*)col));
+		active = _lanes::andnot(_lanes::widen(_mm_cmpeq_epi8(s, pad_char)), _lanes::and_(active, _lanes::cmpgt(xdrop, _lanes::sub(score, st))));
+		if(!_lanes::any(active))
+			break;
+		live = _lanes::mask(active);
+		st = _lanes::add(st, _lanes::and_(_lanes::widen(letter_scores(&matrix[int(char(query[d])) << 5], _mm_and_si128(s, letter_mask))), active));
+		score = _lanes::max(score, st);
+		right = _lanes::sub(right, active);
+	}
+
+	for(unsigned d=0;d<seed_len;++d) {
+		for(unsigned i=0;i<n;++i)
+			col[i] = char(subjects[i][d]);
+		score = _lanes::add(score, _lanes::widen(letter_scores(&matrix[int(char(query[d])) << 5], _mm_and_si128(_mm_load_si128((const __m128i*)col), letter_mask))));
+	}
+
+	int16_t sc[_lanes::lanes], l[_lanes::lanes], r[_lanes::lanes];
+	_lanes::store(sc, score);
+	_lanes::store(l, delta);
+	_lanes::store(r, right);
+	for(unsigned i=0;i<n;++i) {
+		score_out[i] = sc[i];
+		delta_out[i] = l[i];
+		len_out[i] = l[i] + r[i] + seed_len;
+	}
+}
+
+#endif
+
+/* Seed hits of one query position that passed fast_match, extended
+ * together by the SIMD kernel. */
+template<typename _val, typename _locr>
+struct Ungapped_batch
+{
+	void clear()
+	{
+		locs.clear();
+		subjects.clear();
+	}
+	void push(_locr s, const _val *subject)
+	{
+		locs.push_back(s);
+		subjects.push_back(subject);
+	}
+	size_t size() const
+	{ return locs.size(); }
+	void extend(const _val *query, unsigned seed_len)
+	{
+		const size_t n = size();
+		score.resize(n);
+		delta.resize(n);
+		len.resize(n);
+#ifdef __SSSE3__
+		if(program_options::have_ssse3 && program_options::window < max_window) {
+#ifdef __AVX2__
+			if(program_options::have_avx2 && n > Ungapped_lanes_sse::lanes) {
+				extend<Ungapped_lanes_avx2>(query, seed_len);
+				return;
+			}
+#endif
+			extend<Ungapped_lanes_sse>(query, seed_len);
+			return;
+		}
+#endif
+		for(size_t i=0;i<n;++i)
+			score[i] = xdrop_ungapped<_val,_locr,_locr>(query, subjects[i], seed_len, delta[i], len[i]);
+	}
+	vector<_locr> locs;
+	vector<const _val*> subjects;
+	vector<int> score;
+	vector<unsigned> delta, len;
+	static boost::thread_specific_ptr<Ungapped_batch> ptr;
+private:
+	// keeps the 16 bit lane scores from overflowing
+	enum { max_window = 1024 };
+	template<typename _lanes>
+	void extend(const _val *query, unsigned seed_len)
+	{
+		for(size_t i=0;i<size();i+=_lanes::lanes)
+			xdrop_ungapped<_val,_lanes>(query,
+					&subjects[i],
+					std::min(size()-i, (size_t)_lanes::lanes),
+					seed_len,
+					&score[i],
+					&delta[i],
+					&len[i]);
+	}
+};
+
+template<typename _val, typename _locr> boost::thread_specific_ptr<Ungapped_batch<_val,_locr> > Ungapped_batch<_val,_locr>::ptr;
+
 #endif /* ALIGN_UNGAPPED_H_ */
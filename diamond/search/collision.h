@@ -39,7 +39,7 @@ template<typename _val>
 inline bool is_lower_chunk(const _val *subject, unsigned sid)
 {
 	uint64_t seed;
-	shape_config::get().get_shape(sid).set_seed(seed, subject);
+	shape_config::get().get_shape(sid).set_seed(seed, ref_seqs<_val>::data_->reduced(subject));
 	return current_range.lower(seed_partition(seed));
 }
 
@@ -47,7 +47,7 @@ template<typename _val>
 inline bool is_lower_or_equal_chunk(const _val *subject, unsigned sid)
 {
 	uint64_t seed;
-	shape_config::get().get_shape(sid).set_seed(seed, subject);
+	shape_config::get().get_shape(sid).set_seed(seed, ref_seqs<_val>::data_->reduced(subject));
 	return current_range.lower_or_equal(seed_partition(seed));
 }
 
@@ -59,7 +59,7 @@ inline bool need_lookup(unsigned sid)
 
 template<typename _val>
 inline bool is_low_freq(const _val *subject, unsigned sid)
-{ return shape_config::get().get_shape(sid).is_low_freq(subject); }
+{ return shape_config::get().get_shape(sid).is_low_freq(ref_seqs<_val>::data_->reduced(subject)); }
 
 template <typename _val, typename _pos>
 inline bool shape_collision_right(uint64_t mask, uint64_t shape_mask, const _val *subject, unsigned sid)
@@ -137,13 +137,14 @@ bool is_primary_hit(const _val *query,
 {
 	assert(len > 0 && len <= program_options::window*2);
 	const bool chunked (program_options::lowmem > 1);
-	uint64_t mask = reduced_match32(query, subject, len);
+	const uint8_t *query_reduced (query_seqs<_val>::data_->reduced(query)), *subject_reduced (ref_seqs<_val>::data_->reduced(subject));
+	uint64_t mask = reduced_match32(query_reduced, subject_reduced, len);
 	unsigned i = 0;
 	uint64_t current_mask = shape_config::instance.get_shape(sid).mask_;
 	unsigned shape_len =  len - shape_config::instance.get_shape(0).length_ + 1;
 	while(i < shape_len) {
 		if(len-i > 32)
-			mask |= reduced_match32(query+32,subject+32,len-i-32) << 32;
+			mask |= reduced_match32(query_reduced+32,subject_reduced+32,len-i-32) << 32;
 		for(unsigned j=0;j<32 && i<shape_len;++j) {
 			assert(&subject[j] >= ref_seqs<_val>::data_->data(0) && &subject[j] <= ref_seqs<_val>::data_->data(ref_seqs<_val>::data_->raw_len()-1));
 			for(unsigned k=0;k<sid;++k)
@@ -156,8 +157,9 @@ bool is_primary_hit(const _val *query,
 			++i;
 			mask >>= 1;
 		}
-		query += 32;
 		subject += 32;
+		query_reduced += 32;
+		subject_reduced += 32;
 	}
 	return true;
 }
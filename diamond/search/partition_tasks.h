@@ -0,0 +1,196 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef PARTITION_TASKS_H_
+#define PARTITION_TASKS_H_
+
+#include <algorithm>
+#include <omp.h>
+#include "align_range.h"
+#include "../util/work_queue.h"
+
+/* Search tasks over the seed partitions. Seed frequencies are skewed, so
+ * a partition whose estimated cost exceeds the grain size is split at seed
+ * key boundaries into several tasks. */
+
+template<typename _locr, typename _locq>
+struct Partition_task
+{
+	typedef typename sorted_list<_locr>::Type::entry Ref_entry;
+	typedef typename sorted_list<_locq>::Type::entry Query_entry;
+	Partition_task()
+	{ }
+	Partition_task(unsigned seedp, const Ref_entry *i, const Query_entry *j):
+		seedp (seedp),
+		i_begin (i),
+		j_begin (j),
+		cost (0)
+	{ }
+	bool operator<(const Partition_task &rhs) const
+	{ return cost > rhs.cost; }
+	unsigned seedp;
+	const Ref_entry *i_begin, *i_end;
+	const Query_entry *j_begin, *j_end;
+	uint64_t cost;
+};
+
+template<typename _locr, typename _locq>
+uint64_t seed_cost(const typename sorted_list<_locr>::Type::const_iterator &i, const typename sorted_list<_locq>::Type::const_iterator &j)
+{ return (uint64_t)j.n * std::min((uint64_t)i.n, (uint64_t)program_options::hit_cap) + 1; }
+
+template<typename _locr, typename _locq>
+uint64_t partition_cost(typename sorted_list<_locr>::Type::const_iterator i, typename sorted_list<_locq>::Type::const_iterator j)
+{
+	uint64_t cost (0);
+	while(!i.at_end() && !j.at_end()) {
+		if(i.key() < j.key()) {
+			++i;
+		} else if(j.key() < i.key()) {
+			++j;
+		} else {
+			cost += seed_cost<_locr,_locq>(i, j);
+			++i;
+			++j;
+		}
+	}
+	return cost;
+}
+
+template<typename _locr, typename _locq>
+void split_partition(unsigned seedp,
+		typename sorted_list<_locr>::Type::const_iterator i,
+		typename sorted_list<_locq>::Type::const_iterator j,
+		uint64_t grain,
+		vector<Partition_task<_locr,_locq> > &out)
+{
+	Partition_task<_locr,_locq> task (seedp, i.i, j.i);
+	while(!i.at_end() && !j.at_end()) {
+		if(i.key() < j.key()) {
+			++i;
+		} else if(j.key() < i.key()) {
+			++j;
+		} else {
+			task.cost += seed_cost<_locr,_locq>(i, j);
+			++i;
+			++j;
+			if(task.cost >= grain) {
+				task.i_end = i.i;
+				task.j_end = j.i;
+				out.push_back(task);
+				task = Partition_task<_locr,_locq> (seedp, i.i, j.i);
+			}
+		}
+	}
+	if(task.cost > 0) {
+		task.i_end = i.end;
+		task.j_end = j.end;
+		out.push_back(task);
+	}
+}
+
+template<typename _locr, typename _locq>
+vector<Partition_task<_locr,_locq> > partition_tasks(const typename sorted_list<_locr>::Type &ref_idx, const typename sorted_list<_locq>::Type &query_idx)
+{
+	typedef Partition_task<_locr,_locq> Task;
+	vector<uint64_t> cost (Const::seedp);
+#pragma omp parallel for schedule(dynamic)
+	for(unsigned seedp=0;seedp<Const::seedp;++seedp)
+		cost[seedp] = partition_cost<_locr,_locq>(ref_idx.get_partition_cbegin(seedp), query_idx.get_partition_cbegin(seedp));
+
+	uint64_t total (0);
+	for(unsigned seedp=0;seedp<Const::seedp;++seedp)
+		total += cost[seedp];
+	// aim for about 16 tasks per thread
+	const uint64_t grain (std::max(total / (program_options::threads() * 16), (uint64_t)1));
+
+	vector<vector<Task> > parts (Const::seedp);
+#pragma omp parallel for schedule(dynamic)
+	for(unsigned seedp=0;seedp<Const::seedp;++seedp)
+		if(cost[seedp] > 0)
+			split_partition<_locr,_locq>(seedp, ref_idx.get_partition_cbegin(seedp), query_idx.get_partition_cbegin(seedp), grain, parts[seedp]);
+
+	vector<Task> tasks;
+	for(unsigned seedp=0;seedp<Const::seedp;++seedp)
+		tasks.insert(tasks.end(), parts[seedp].begin(), parts[seedp].end());
+	std::stable_sort(tasks.begin(), tasks.end());
+	return tasks;
+}
+
+template<typename _val, typename _locr, typename _locq, typename _locl>
+void search_partitions(unsigned sid,
+		const typename sorted_list<_locr>::Type &ref_idx,
+		const typename sorted_list<_locq>::Type &query_idx)
+{
+	typedef Partition_task<_locr,_locq> Task;
+	typedef typename sorted_list<_locr>::Type::const_iterator Ref_iterator;
+	typedef typename sorted_list<_locq>::Type::const_iterator Query_iterator;
+
+	const vector<Task> tasks (partition_tasks<_locr,_locq>(ref_idx, query_idx));
+	vector<size_t> ids (tasks.size());
+	for(size_t i=0;i<ids.size();++i)
+		ids[i] = i;
+	Work_queue<size_t> queue (ids, program_options::threads());
+	vector<double> task_time (tasks.size()), finish_time (program_options::threads());
+	const double start (omp_get_wtime());
+
+#pragma omp parallel num_threads(program_options::threads())
+	{
+		Statistics stat;
+		const unsigned thread (omp_get_thread_num());
+		size_t n;
+		while(queue.get(thread, n)) {
+			const Task &task (tasks[n]);
+			const double t (omp_get_wtime());
+			try {
+				align_partition<_val,_locr,_locq,_locl>(stat,
+						sid,
+						Ref_iterator (task.i_begin, task.i_end),
+						Query_iterator (task.j_begin, task.j_end));
+			} catch (std::exception &e) {
+				exception_state.set(e);
+			}
+			task_time[n] = omp_get_wtime() - t;
+		}
+		finish_time[thread] = omp_get_wtime();
+#pragma omp critical
+		statistics += stat;
+	}
+
+	vector<double> partition_time (Const::seedp);
+	vector<unsigned> partition_ntasks (Const::seedp);
+	for(size_t i=0;i<tasks.size();++i) {
+		partition_time[tasks[i].seedp] += task_time[i];
+		++partition_ntasks[tasks[i].seedp];
+	}
+	const unsigned max_p (std::max_element(partition_time.begin(), partition_time.end()) - partition_time.begin());
+	double total (0), end (start), idle (0);
+	for(unsigned i=0;i<Const::seedp;++i)
+		total += partition_time[i];
+	for(unsigned i=0;i<finish_time.size();++i)
+		end = std::max(end, finish_time[i]);
+	for(unsigned i=0;i<finish_time.size();++i)
+		if(finish_time[i] > 0)
+			idle += end - finish_time[i];
+	log_stream << "Partition search time: mean = " << total / Const::seedp << "s, max = " << partition_time[max_p] << "s (partition " << max_p
+			<< ", " << partition_ntasks[max_p] << " tasks)" << endl;
+	log_stream << "Partition tasks = " << tasks.size() << ", steals = " << queue.steals() << ", thread idle time = " << idle << "s" << endl;
+}
+
+#endif /* PARTITION_TASKS_H_ */
@@ -54,61 +54,62 @@ template<typename _val>
 unsigned fast_match(const _val *q, const _val *s)
 { return popcount_3(match_block(q-8, s-8)<<16 | match_block(q+8, s+8)); }
 
-template<typename _val>
-__m128i reduce_seq_ssse3(const __m128i &seq)
-{
-#ifdef __SSSE3__
-	const __m128i *row = reinterpret_cast<const __m128i*>(Reduction<_val>::reduction.map8());
-	__m128i high_mask = _mm_slli_epi16(_mm_and_si128(seq, _mm_set1_epi8(0x10)), 3);
-	__m128i seq_low = _mm_or_si128(seq, high_mask);
-	__m128i seq_high = _mm_or_si128(seq, _mm_xor_si128(high_mask, _mm_set1_epi8(0x80)));
-
-	__m128i r1 = _mm_load_si128(row);
-	__m128i r2 = _mm_load_si128(row+1);
-	__m128i s1 = _mm_shuffle_epi8(r1, seq_low);
-	__m128i s2 = _mm_shuffle_epi8(r2, seq_high);
-	return _mm_or_si128(s1, s2);
-#endif
-}
+enum { match_window_size = 32 };
 
+/* Copies the letters compared by fast_match around subject position s,
+ * with the mask bit cleared. */
 template<typename _val>
-__m128i reduce_seq_generic(const __m128i &seq)
+void copy_match_window(const _val *s, uint8_t *dst)
 {
-	__m128i r;
-	_val* s = (_val*)&seq;
-	uint8_t* d = (uint8_t*)&r;
-	for(unsigned i=0;i<16;++i)
-		*(d++) = Reduction<_val>::reduction(*(s++));
-	return r;
+	const __m128i mask = _mm_set1_epi8(0x7F);
+	_mm_storeu_si128((__m128i*)dst, _mm_and_si128(_mm_loadu_si128((__m128i const*)(s-8)), mask));
+	_mm_storeu_si128((__m128i*)(dst+16), _mm_and_si128(_mm_loadu_si128((__m128i const*)(s+8)), mask));
 }
 
-template<typename _val>
-__m128i reduce_seq(const __m128i &seq)
+/* fast_match of a fixed query position against windows made by
+ * copy_match_window. */
+struct Match_window
 {
-	if(program_options::have_ssse3) {
-#ifdef __SSSE3__
-		return reduce_seq_ssse3<_val>(seq);
-#else
-		return reduce_seq_generic<_val>(seq);
+	template<typename _val>
+	Match_window(const _val *q):
+		q1 (_mm_loadu_si128((__m128i const*)(q-8))),
+		q2 (_mm_loadu_si128((__m128i const*)(q+8)))
+	{ }
+	unsigned operator()(const uint8_t *w) const
+	{
+		const unsigned x = _mm_movemask_epi8(_mm_cmpeq_epi8(q1, _mm_loadu_si128((__m128i const*)w)));
+		const unsigned y = _mm_movemask_epi8(_mm_cmpeq_epi8(q2, _mm_loadu_si128((__m128i const*)(w+16))));
+		return popcount_3(x<<16 | y);
+	}
+	__m128i q1, q2;
+};
+
+#ifdef __AVX2__
+struct Match_window_avx2
+{
+	template<typename _val>
+	Match_window_avx2(const _val *q):
+		q (_mm256_loadu_si256((__m256i const*)(q-8)))
+	{ }
+	unsigned operator()(const uint8_t *w) const
+	{ return popcount_3((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(q, _mm256_loadu_si256((__m256i const*)w)))); }
+	__m256i q;
+};
 #endif
-	} else
-		return reduce_seq_generic<_val>(seq);
-}
 
-template<typename _val>
-unsigned match_block_reduced(const _val *x, const _val *y)
+/* Compares reduced alphabet shadows made by Sequence_set::build_reduced.
+ * Masked letters and padding compare as class 0. */
+inline unsigned match_block_reduced(const uint8_t *x, const uint8_t *y)
 {
 	static const __m128i mask = _mm_set1_epi8(0x7F);
 	__m128i r1 = _mm_loadu_si128 ((__m128i const*)(x));
 	__m128i r2 = _mm_loadu_si128 ((__m128i const*)(y));
+	r1 = _mm_and_si128(r1, mask);
 	r2 = _mm_and_si128(r2, mask);
-	r1 = reduce_seq<_val>(r1);
-	r2 = reduce_seq<_val>(r2);
 	return _mm_movemask_epi8(_mm_cmpeq_epi8(r1, r2));
 }
 
-template<typename _val>
-uint64_t reduced_match32(const _val* q, const _val *s, unsigned len)
+inline uint64_t reduced_match32(const uint8_t* q, const uint8_t *s, unsigned len)
 {
 	uint64_t x = match_block_reduced(q+16, s+16)<<16 | match_block_reduced(q,s);
 	if(len < 32)
@@ -30,12 +30,35 @@ template<typename _locr, typename _locl>
 struct Trace_pt_buffer : public Async_buffer<hit<_locr,_locl> >
 {
 	Trace_pt_buffer(size_t input_size, const string &tmpdir, bool mem_buffered):
-		Async_buffer<hit<_locr,_locl> > (input_size, tmpdir, mem_buffered ? mem_bins : file_bins)
+		Async_buffer<hit<_locr,_locl> > (input_size, tmpdir, bin_count(input_size, mem_buffered))
 	{ }
+	void close()
+	{
+		Async_buffer<hit<_locr,_locl> >::close();
+		hits_estimate = this->size();
+	}
 	enum { mem_bins = 1, file_bins = 4 };
 	static Trace_pt_buffer *instance;
+private:
+	/* With --bin-mem, the hit count of the previous reference block is taken
+	   as estimate. Two bins are in memory at a time while aligning. */
+	static unsigned bin_count(size_t input_size, bool mem_buffered)
+	{
+		unsigned n;
+		if(program_options::trace_pt_bins > 0)
+			n = program_options::trace_pt_bins;
+		else if(program_options::bin_mem > 0 && hits_estimate > 0)
+			n = (unsigned)std::ceil(2.0 * hits_estimate * sizeof(hit<_locr,_locl>) / (program_options::bin_mem * 1e9));
+		else
+			n = mem_buffered ? mem_bins : file_bins;
+		n = std::max(1u, std::min(n, (unsigned)std::max(input_size, size_t(1))));
+		log_stream << "Trace point bins = " << n << endl;
+		return n;
+	}
+	static size_t hits_estimate;
 };
 
 template<typename _locr, typename _locl> Trace_pt_buffer<_locr,_locl>* Trace_pt_buffer<_locr,_locl>::instance;
+template<typename _locr, typename _locl> size_t Trace_pt_buffer<_locr,_locl>::hits_estimate = 0;
 
 #endif /* TRACE_PT_BUFFER_H_ */
@@ -0,0 +1,79 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef TEST_ALIGN_UNGAPPED_H_
+#define TEST_ALIGN_UNGAPPED_H_
+
+#include <stdlib.h>
+#include <vector>
+#include "test.h"
+#include "../search/align_ungapped.h"
+
+using std::vector;
+
+/* The batched ungapped extension has to agree with xdrop_ungapped. The window
+   is wider than the subjects, so most lanes stop on the padding long before the
+   others, and every subject sits between single padding letters in its own
+   allocation. */
+
+void test_ungapped_batch()
+{
+#ifdef __SSSE3__
+	namespace po = program_options;
+	if(!po::have_ssse3)
+		return;
+	const Amino_acid pad (String_set<Amino_acid>::PADDING_CHAR);
+	const unsigned window = po::window, seed_len = 12;
+	const bool avx2 = po::have_avx2;
+	po::window = 1000;
+	srand(1);
+	for(unsigned n=0;n<200;++n) {
+		const int len = 100 + rand() % 700, anchor = len / 2;
+		vector<Amino_acid> q (1, pad);
+		for(int i=0;i<len;++i)
+			q.push_back(Amino_acid(rand() % 20));
+		q.push_back(pad);
+		const unsigned count = 1 + rand() % 40;
+		vector<vector<Amino_acid> > s (count);
+		Ungapped_batch<Amino_acid,unsigned> batch;
+		for(unsigned i=0;i<count;++i) {
+			const int left = rand() % 60, right = seed_len + rand() % 200;
+			s[i].push_back(pad);
+			for(int j=anchor-left;j<anchor+right;++j)
+				s[i].push_back(j >= 0 && j < len && rand() % 100 >= 20 ? q[1+j] : Amino_acid(rand() % 20));
+			s[i].push_back(pad);
+			batch.push(i, &s[i][1+left]);
+		}
+		for(unsigned k=0;k<2;++k) {
+			po::have_avx2 = avx2 && k == 1;
+			batch.extend(&q[1+anchor], seed_len);
+			for(unsigned i=0;i<count;++i) {
+				unsigned delta, l;
+				const int score = xdrop_ungapped<Amino_acid,unsigned,unsigned>(&q[1+anchor], batch.subjects[i], seed_len, delta, l);
+				TEST_CHECK(batch.score[i] == score && batch.delta[i] == delta && batch.len[i] == l);
+			}
+		}
+	}
+	po::have_avx2 = avx2;
+	po::window = window;
+#endif
+}
+
+#endif /* TEST_ALIGN_UNGAPPED_H_ */
@@ -0,0 +1,130 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef TEST_FILTER_TABLE_H_
+#define TEST_FILTER_TABLE_H_
+
+#include <stdlib.h>
+#include <vector>
+#include <memory>
+#include <iostream>
+#include <boost/timer/timer.hpp>
+#include "test.h"
+#include "../util/filter_table.h"
+#include "../util/hash_table.h"
+
+using std::vector;
+using std::auto_ptr;
+using std::cout;
+
+/* Keys of partition p: even keys are inserted, odd keys are absent. */
+inline uint32_t filter_test_key(unsigned p, unsigned i, bool present)
+{ return (uint32_t(i) * 2654435761u + p) * 2 + (present ? 0 : 1); }
+
+inline uint8_t filter_test_value(unsigned p, unsigned i)
+{ return uint8_t((i * 7 + p) % 256); }
+
+/* Filter_table against the inserted key/treshold pairs. Partitions range from
+   empty to well beyond one bucket, so lookups run into full buckets and wrap
+   around the table; tresholds of 0 read as absent. */
+
+void test_filter_table()
+{
+	const unsigned sizes[] = { 0, 1, 12, 13, 100, 5000 };
+	const unsigned begin = 7, end = 7 + sizeof(sizes)/sizeof(sizes[0]);
+	auto_ptr<Filter_table> table (new Filter_table);
+	vector<unsigned> counts (Const::seedp);
+	for(unsigned p=begin;p<end;++p)
+		counts[p] = sizes[p-begin];
+	for(unsigned k=0;k<2;++k) {
+		table->init(begin, end, counts.data());
+		for(unsigned p=begin;p<end;++p) {
+			table->clear(p);
+			for(unsigned i=0;i<counts[p];++i)
+				table->insert(p, filter_test_key(p, i, true), filter_test_value(p, i));
+		}
+		for(unsigned p=begin;p<end;++p)
+			for(unsigned i=0;i<counts[p]+100;++i) {
+				if(i < counts[p])
+					TEST_CHECK(table->get(p, filter_test_key(p, i, true)) == filter_test_value(p, i));
+				TEST_CHECK(table->get(p, filter_test_key(p, i, false)) == 0);
+			}
+	}
+}
+
+/* Micro-benchmark of the position filter tables, run by the hidden "diamond
+   benchmark" command: building and querying Filter_table against the
+   hash_table per partition it replaced, over all seed partitions with half of
+   the lookups hitting. */
+
+void benchmark_filter_table()
+{
+	typedef hash_table<uint32_t, uint8_t, value_compare<uint8_t, 0>, murmur_hash> Old_table;
+	const unsigned sizes[] = { 200, 2000, 20000 }, lookups = 20000000;
+	cout << "keys/partition\tbuild old\tbuild new\tlookups old\tlookups new" << endl;
+	for(unsigned s=0;s<sizeof(sizes)/sizeof(sizes[0]);++s) {
+		const unsigned n = sizes[s];
+		vector<unsigned> counts (Const::seedp, n);
+		vector<uint32_t> keys (lookups);
+		vector<unsigned> parts (lookups);
+		srand(1);
+		for(unsigned i=0;i<lookups;++i) {
+			parts[i] = rand() % Const::seedp;
+			keys[i] = filter_test_key(parts[i], rand() % n, i % 2 == 0);
+		}
+		uint64_t sum_old = 0, sum_new = 0;
+
+		boost::timer::cpu_timer timer;
+		vector<Old_table*> old_tables (Const::seedp);
+		for(unsigned p=0;p<Const::seedp;++p) {
+			old_tables[p] = new Old_table (std::max((size_t)(n * 1.3f), (size_t)n + 1));
+			for(unsigned i=0;i<n;++i)
+				old_tables[p]->insert(filter_test_key(p, i, true), filter_test_value(p, i) | 1);
+		}
+		const double build_old = timer.elapsed().wall / 1e9;
+		timer.start();
+		for(unsigned i=0;i<lookups;++i) {
+			const Old_table::entry *e = (*old_tables[parts[i]])[keys[i]];
+			sum_old += e ? e->value : 0;
+		}
+		const double lookup_old = timer.elapsed().wall / 1e9;
+		for(unsigned p=0;p<Const::seedp;++p)
+			delete old_tables[p];
+
+		timer.start();
+		auto_ptr<Filter_table> table (new Filter_table);
+		table->init(0, Const::seedp, counts.data());
+		for(unsigned p=0;p<Const::seedp;++p) {
+			table->clear(p);
+			for(unsigned i=0;i<n;++i)
+				table->insert(p, filter_test_key(p, i, true), filter_test_value(p, i) | 1);
+		}
+		const double build_new = timer.elapsed().wall / 1e9;
+		timer.start();
+		for(unsigned i=0;i<lookups;++i)
+			sum_new += table->get(parts[i], keys[i]);
+		const double lookup_new = timer.elapsed().wall / 1e9;
+
+		cout << n << '\t' << build_old << '\t' << build_new << '\t' << lookup_old << '\t' << lookup_new
+				<< (sum_old == sum_new ? "" : "\tMISMATCH") << endl;
+	}
+}
+
+#endif /* TEST_FILTER_TABLE_H_ */
@@ -0,0 +1,91 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef TEST_FLOATING_SW_H_
+#define TEST_FLOATING_SW_H_
+
+#include <stdlib.h>
+#include <vector>
+#include "test.h"
+#include "../dp/floating_sw.h"
+
+using std::vector;
+
+template<typename _dir, typename _traceback>
+void test_floating_sw_dir(const Amino_acid *query, const Amino_acid *subject, int band, int xdrop)
+{
+	namespace po = program_options;
+	po::have_avx2 = false;
+	local_match<Amino_acid> a (floating_sw_dir<Amino_acid,_dir,int,_traceback>(query, subject, band, xdrop, 12, 1));
+	po::have_avx2 = true;
+	local_match<Amino_acid> b (floating_sw_dir<Amino_acid,_dir,int,_traceback>(query, subject, band, xdrop, 12, 1));
+	TEST_CHECK(a.score_ == b.score_);
+	TEST_CHECK(a.query_len_ == b.query_len_ && a.subject_len_ == b.subject_len_ && a.len_ == b.len_);
+	TEST_CHECK(a.identities_ == b.identities_ && a.mismatches_ == b.mismatches_ && a.gap_openings_ == b.gap_openings_);
+	TEST_CHECK((a.transcript_ == 0) == (b.transcript_ == 0));
+	if(a.transcript_ != 0 && b.transcript_ != 0)
+		TEST_CHECK(*a.transcript_ == *b.transcript_);
+	delete a.transcript_;
+	delete b.transcript_;
+}
+
+/* The AVX2 column loop of floating_sw has to give the same alignments as the
+   scalar loop. Pairs of related sequences with substitutions and indels are
+   extended in both directions, with and without traceback. */
+
+void test_floating_sw_avx2()
+{
+#ifdef __AVX2__
+	namespace po = program_options;
+	if(!po::have_avx2)
+		return;
+	const Amino_acid pad (String_set<Amino_acid>::PADDING_CHAR);
+	const int bands[] = { 4, 16, 40 };
+	srand(1);
+	for(unsigned n=0;n<2000;++n) {
+		const int len = 20 + rand() % 400, anchor = len / 2;
+		vector<Amino_acid> q (1, pad), s (1, pad);
+		int s_anchor = 0;
+		for(int i=0;i<len;++i)
+			q.push_back(Amino_acid(rand() % 20));
+		for(int i=0;i<len;++i) {
+			const int r = rand() % 100;
+			if(r < 4 && i != anchor)
+				continue;
+			if(r >= 4 && r < 8)
+				s.push_back(Amino_acid(rand() % 20));
+			if(i == anchor)
+				s_anchor = s.size();
+			s.push_back(r < 25 ? Amino_acid(rand() % 20) : q[1+i]);
+		}
+		q.push_back(pad);
+		s.push_back(pad);
+		const Amino_acid *query = &q[1+anchor], *subject = &s[s_anchor];
+		const int band = bands[n % 3], xdrop = n % 2 ? 20 : 60;
+		test_floating_sw_dir<Right,Score_only>(query, subject, band, xdrop);
+		test_floating_sw_dir<Left,Score_only>(query, subject, band, xdrop);
+		test_floating_sw_dir<Right,Traceback>(query, subject, band, xdrop);
+		test_floating_sw_dir<Left,Traceback>(query, subject, band, xdrop);
+	}
+	po::have_avx2 = true;
+#endif
+}
+
+#endif /* TEST_FLOATING_SW_H_ */
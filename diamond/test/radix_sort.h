@@ -0,0 +1,254 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef TEST_RADIX_SORT_H_
+#define TEST_RADIX_SORT_H_
+
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <iostream>
+#include <boost/timer/timer.hpp>
+#include "test.h"
+#include "../util/radix_sort.h"
+#include "../data/sorted_list.h"
+#include "../data/load_seqs.h"
+#include "../align/align_queries.h"
+
+using std::vector;
+using std::auto_ptr;
+using std::cout;
+using std::endl;
+
+struct Test_sort_entry
+{
+	uint64_t key;
+	unsigned pos;
+	bool operator<(const Test_sort_entry &rhs) const
+	{ return key < rhs.key; }
+	bool operator==(const Test_sort_entry &rhs) const
+	{ return key == rhs.key && pos == rhs.pos; }
+};
+
+struct Test_sort_key
+{
+	uint64_t operator()(const Test_sort_entry &e) const
+	{ return e.key; }
+};
+
+vector<Test_sort_entry> test_sort_input(size_t n, uint64_t key_min, uint64_t keys)
+{
+	vector<Test_sort_entry> v (n);
+	for(size_t i=0;i<n;++i) {
+		v[i].key = key_min + ((uint64_t(rand()) << 31) ^ uint64_t(rand())) % keys;
+		v[i].pos = (unsigned)i;
+	}
+	return v;
+}
+
+/* radix_sort and counting_sort against std::stable_sort, for key ranges below,
+   near and above the input size and for more threads than the counts allow. */
+
+void test_radix_sort()
+{
+	srand(1);
+	const size_t sizes[] = { 2, 1000, 70000, 300000 };
+	const uint64_t key_ranges[] = { 1, 7, 5000, 1000000, uint64_t(1) << 40 };
+	const unsigned threads[] = { 1, 4, 64 };
+	for(unsigned i=0;i<sizeof(sizes)/sizeof(sizes[0]);++i)
+		for(unsigned j=0;j<sizeof(key_ranges)/sizeof(key_ranges[0]);++j) {
+			const vector<Test_sort_entry> v (test_sort_input(sizes[i], 3, key_ranges[j]));
+			vector<Test_sort_entry> expected (v), buffer (v.size());
+			std::stable_sort(expected.begin(), expected.end());
+
+			vector<Test_sort_entry> r (v);
+			radix_sort(&r.front(), &r.front() + r.size(), &buffer.front(), 48, Test_sort_key ());
+			TEST_CHECK(r == expected);
+
+			if(key_ranges[j] > 1000000)
+				continue;
+			for(unsigned k=0;k<sizeof(threads)/sizeof(threads[0]);++k) {
+				vector<Test_sort_entry> c (v);
+				counting_sort(&c.front(), &c.front() + c.size(), &buffer.front(), 3, 3 + key_ranges[j] - 1, threads[k], Test_sort_key ());
+				TEST_CHECK(c == expected);
+			}
+		}
+}
+
+/* A set of about the given number of letters, drawn in turn from the sequences
+   of src. */
+Sequence_set<Amino_acid>* benchmark_sort_seqs(const Sequence_set<Amino_acid> &src, size_t letters)
+{
+	Sequence_set<Amino_acid> *seqs = new Sequence_set<Amino_acid> ();
+	for(size_t i=0, n=0;n<letters;i=(i+1)%src.get_length()) {
+		const sequence<const Amino_acid> s = src[i];
+		seqs->push_back(vector<Amino_acid> (s.data(), s.data() + s.length()));
+		n += s.length();
+	}
+	seqs->finish_reserve();
+	seqs->build_reduced();
+	return seqs;
+}
+
+/* std::sort against radix_sort on the seed partitions of the first shape, for
+   sets scaled so that the partitions fall below, near and above the cutoff of
+   sorted_list::sort_partition. The sequences are read from -q if given, else
+   drawn at random. Partitions are shuffled before sorting and timed by size
+   class. */
+
+void benchmark_radix_sort()
+{
+	typedef sorted_list<uint32_t>::Type List;
+	typedef List::entry Entry;
+	namespace po = program_options;
+	po::set_option(po::index_mode, 1u);
+	shape_config::instance = shape_config (po::index_mode, Amino_acid());
+	const shape &sh = shape_config::get().get_shape(0);
+	const unsigned bits = List::key_bits<Amino_acid>(sh);
+
+	Sequence_set<Amino_acid> *src = 0;
+	String_set<char,0> *ids = 0;
+	if(!po::query_file.empty()) {
+		Input_buffer file (po::query_file, true);
+		if(load_seqs<Amino_acid,Amino_acid>(file, FASTA_format<Amino_acid> (), src, ids, std::numeric_limits<size_t>::max()) == 0)
+			throw std::runtime_error("No sequences in query file.");
+		delete ids;
+	} else {
+		src = new Sequence_set<Amino_acid> ();
+		srand(1);
+		for(unsigned i=0;i<20000;++i) {
+			vector<Amino_acid> s (100 + rand() % 500);
+			for(size_t j=0;j<s.size();++j)
+				s[j] = Amino_acid(rand() % 20);
+			src->push_back(s);
+		}
+		src->finish_reserve();
+	}
+
+	const size_t class_limits[] = { 256, 512, 768, 1024, 1280, 2048, 8192, std::numeric_limits<size_t>::max() };
+	const unsigned classes = sizeof(class_limits)/sizeof(class_limits[0]);
+	vector<Entry> input[classes];
+	vector<size_t> bounds[classes];
+	for(unsigned c=0;c<classes;++c)
+		bounds[c].push_back(0);
+
+	const size_t partition_letters[] = { 128, 512, 1024, 2048, 8192 };
+	for(unsigned k=0;k<sizeof(partition_letters)/sizeof(partition_letters[0]);++k) {
+		Sequence_set<Amino_acid> *seqs = benchmark_sort_seqs(*src, partition_letters[k] * Const::seedp);
+		const auto_ptr<seed_histogram> hst (new seed_histogram (*seqs, Amino_acid()));
+		const shape_histogram &shst = hst->get(po::index_mode, 0);
+		const seedp_range range (0, Const::seedp);
+		vector<char> buffer (sizeof(Entry) * std::max(hst_size(shst, range), (size_t)1));
+		const List list (buffer.data(), *seqs, sh, shst, range);
+		const Entry *p = list.data();
+		for(unsigned i=0;i<Const::seedp;++i) {
+			const size_t n = partition_size(shst, i);
+			unsigned c = 0;
+			while(n >= class_limits[c])
+				++c;
+			const size_t begin = input[c].size();
+			input[c].insert(input[c].end(), p, p + n);
+			std::random_shuffle(input[c].begin() + begin, input[c].end());
+			bounds[c].push_back(input[c].size());
+			p += n;
+		}
+		delete seqs;
+	}
+	delete src;
+
+	cout << "partition size\tpartitions\tentries\tstd::sort\tradix_sort" << endl;
+	for(unsigned c=0;c<classes;++c) {
+		if(input[c].empty())
+			continue;
+		const size_t parts = bounds[c].size() - 1;
+		vector<Entry> a (input[c]), b (input[c]), buffer (input[c].size());
+		boost::timer::cpu_timer timer;
+		for(size_t i=0;i<parts;++i)
+			std::sort(&a[0] + bounds[c][i], &a[0] + bounds[c][i+1]);
+		const double t_std = timer.elapsed().wall / 1e9;
+		timer.start();
+		for(size_t i=0;i<parts;++i)
+			radix_sort(&b[0] + bounds[c][i], &b[0] + bounds[c][i+1], buffer.data(), bits, List::Entry_key ());
+		const double t_radix = timer.elapsed().wall / 1e9;
+
+		bool match = true;
+		for(size_t i=0;i<a.size();++i)
+			match &= a[i].key == b[i].key;
+		cout << (c == 0 ? 0 : class_limits[c-1]) << '-';
+		if(c + 1 < classes)
+			cout << class_limits[c] - 1;
+		cout << '\t' << parts << '\t' << input[c].size() << '\t' << t_std << '\t' << t_radix
+				<< (match ? "" : "\tMISMATCH") << endl;
+	}
+}
+
+/* Trace points of queries*contexts query ids in random order, with a skewed
+   number of hits per query as the search stage produces them. */
+vector<hit<uint32_t,uint8_t> > benchmark_trace_pts(size_t n, unsigned queries, unsigned contexts)
+{
+	vector<hit<uint32_t,uint8_t> > v;
+	v.reserve(n);
+	while(v.size() < n) {
+		const unsigned q = rand() % queries, hits = rand() % 100 == 0 ? rand() % 2000 : rand() % 20;
+		for(unsigned i=0;i<hits && v.size() < n;++i)
+			v.push_back(hit<uint32_t,uint8_t> (q*contexts + rand() % contexts, rand(), rand() % 64));
+	}
+	std::random_shuffle(v.begin(), v.end());
+	return v;
+}
+
+/* The sort of the trace points of a query bin before the alignment stage, as
+   __gnu_parallel::sort did it against the counting sort of group_by_query. */
+
+void benchmark_counting_sort()
+{
+	typedef hit<uint32_t,uint8_t> Hit;
+	const size_t sizes[] = { 1000000, 4000000, 16000000 };
+	const unsigned queries[] = { 10000, 100000, 1000000 }, contexts[] = { 1, 6 };
+	srand(1);
+	cout << "threads " << program_options::threads() << endl;
+	cout << "trace points\tqueries\tcontexts\tparallel sort\tcounting sort" << endl;
+	for(unsigned i=0;i<sizeof(sizes)/sizeof(sizes[0]);++i)
+		for(unsigned j=0;j<sizeof(queries)/sizeof(queries[0]);++j)
+			for(unsigned k=0;k<sizeof(contexts)/sizeof(contexts[0]);++k) {
+				const vector<Hit> v (benchmark_trace_pts(sizes[i], queries[j], contexts[k]));
+				vector<Hit> a (v), b (v);
+				boost::timer::cpu_timer timer;
+#if __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 3)
+				__gnu_parallel::sort(a.begin(), a.end());
+#else
+				merge_sort(a.begin(), a.end(), program_options::threads());
+#endif
+				const double t_sort = timer.elapsed().wall / 1e9;
+				timer.start();
+				group_by_query<uint32_t,uint8_t>(b);
+				const double t_counting = timer.elapsed().wall / 1e9;
+
+				bool match = true;
+				for(size_t l=0;l<a.size();++l)
+					match &= a[l].query_ == b[l].query_;
+				cout << sizes[i] << '\t' << queries[j] << '\t' << contexts[k] << '\t' << t_sort << '\t' << t_counting
+						<< (match ? "" : "\tMISMATCH") << endl;
+			}
+}
+
+#endif /* TEST_RADIX_SORT_H_ */
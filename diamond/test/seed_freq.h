@@ -0,0 +1,123 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef TEST_SEED_FREQ_H_
+#define TEST_SEED_FREQ_H_
+
+#include <stdlib.h>
+#include <vector>
+#include <utility>
+#include "test.h"
+#include "../basic/shape_config.h"
+#include "../basic/seed_enumerator.h"
+
+using std::vector;
+using std::pair;
+
+struct Test_seed_list
+{
+	void operator()(unsigned j, uint64_t key)
+	{ seeds.push_back(pair<unsigned,uint64_t> (j, key)); }
+	vector<pair<unsigned,uint64_t> > seeds;
+};
+
+/* The seeds of a reduced sequence by the plain double sum of background_freq,
+   as shape::set_seed decided them before the fixed point tables. */
+vector<pair<unsigned,uint64_t> > test_seeds_double(const shape &sh, const uint8_t *reduced, unsigned n)
+{
+	vector<pair<unsigned,uint64_t> > v;
+	for(unsigned j=0;j<n;++j) {
+		uint64_t s = 0;
+		double f = 0;
+		bool masked = false;
+		for(unsigned i=0;i<sh.weight_;++i) {
+			const unsigned r = reduced[j+sh.positions_[i]];
+			masked |= (r & 0x80) != 0;
+			f += background_freq[r & 0x7F];
+			s = s*11 + (r & 0x7F);
+		}
+		if(!masked && f <= program_options::max_seed_freq)
+			v.push_back(pair<unsigned,uint64_t> (j, s));
+	}
+	return v;
+}
+
+void test_seed_freq_shape(const char *code, double seed_freq, const vector<uint8_t> &reduced, unsigned n)
+{
+	namespace po = program_options;
+	po::max_seed_freq = seed_freq;
+	const shape sh (code, 0);
+	const vector<pair<unsigned,uint64_t> > expected (test_seeds_double(sh, reduced.data(), n));
+
+	Test_seed_list scalar;
+	uint64_t s;
+	for(unsigned j=0;j<n;++j)
+		if(sh.set_seed(s, reduced.data() + j)) {
+			TEST_CHECK(sh.is_low_freq(reduced.data() + j));
+			scalar(j, s);
+		}
+	TEST_CHECK(scalar.seeds == expected);
+
+	const bool ssse3 = po::have_ssse3;
+	for(unsigned k=0;k<2;++k) {
+		po::have_ssse3 = ssse3 && k == 1;
+		Test_seed_list simd;
+		Seed_enumerator (sh).enumerate(reduced.data(), n, simd);
+		TEST_CHECK(simd.seeds == expected);
+	}
+	po::have_ssse3 = ssse3;
+}
+
+/* The fixed point and the SSSE3 seed frequency decisions of all shapes against
+   the double sum, for a range of --seed-freq values and for thresholds equal to
+   the exact frequency of a seed of the sequence. Letters are drawn with a bias
+   towards the frequent groups so that seeds fall on both sides of the usual
+   thresholds. */
+
+void test_seed_freq()
+{
+	const double seed_freq = program_options::max_seed_freq;
+	const double thresholds[] = { -1000, -40, -25, -20, -17.5, -15, -13, -11, -9, -5, 0, 10 };
+	const unsigned n = 3000;
+	srand(1);
+	for(unsigned mode=0;mode<Const::index_modes;++mode)
+		for(unsigned i=0;i<Const::max_shapes && shape_codes<Amino_acid>::str[mode][i];++i) {
+			const char *code = shape_codes<Amino_acid>::str[mode][i];
+			vector<uint8_t> reduced (n + strlen(code));
+			for(size_t j=0;j<reduced.size();++j) {
+				const int r = rand() % 100;
+				reduced[j] = uint8_t(r < 30 ? 0 : (r < 45 ? 7 : (r < 60 ? 10 : rand() % 11)));
+				if(rand() % 100 == 0 || j >= n)
+					reduced[j] |= 0x80;
+			}
+			for(unsigned t=0;t<sizeof(thresholds)/sizeof(thresholds[0]);++t)
+				test_seed_freq_shape(code, thresholds[t], reduced, n);
+			const shape sh (code, 0);
+			for(unsigned j=0;j<n;j+=97) {
+				double f = 0;
+				for(unsigned k=0;k<sh.weight_;++k)
+					f += background_freq[reduced[j+sh.positions_[k]] & 0x7F];
+				test_seed_freq_shape(code, f, reduced, n);
+			}
+		}
+	program_options::max_seed_freq = seed_freq;
+}
+
+#endif /* TEST_SEED_FREQ_H_ */
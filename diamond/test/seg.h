@@ -0,0 +1,86 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef TEST_SEG_H_
+#define TEST_SEG_H_
+
+#include <stdlib.h>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "test.h"
+#include "../util/seg.h"
+#include "../algo/blast/core/blast_filter.h"
+
+using std::vector;
+using std::pair;
+
+void test_seg_sequence(Seg &seg, SegParameters *params, const vector<char> &s)
+{
+	vector<pair<int,int> > expected, segs;
+	BlastSeqLoc *locs;
+	SeqBufferSeg((Uint1*)s.data(), (Int4)s.size(), 0, params, &locs);
+	for(BlastSeqLoc *l=locs;l!=0;l=l->next)
+		expected.push_back(pair<int,int> (l->ssr->left, l->ssr->right));
+	BlastSeqLocFree(locs);
+	const vector<Seg::Segment> &r = seg(s.data(), (int)s.size());
+	for(vector<Seg::Segment>::const_iterator i=r.begin();i!=r.end();++i)
+		segs.push_back(pair<int,int> (i->begin, i->end));
+	std::sort(expected.begin(), expected.end());
+	std::sort(segs.begin(), segs.end());
+	TEST_CHECK(segs == expected);
+}
+
+/* Seg against SeqBufferSeg of blast_seg.c with the protein defaults, for
+   random sequences, reduced alphabets, periodic repeats, invalid letters and
+   long low complexity stretches that reach the Stirling approximation of
+   ln_fact. One Seg instance is reused, as per thread instances are. */
+
+void test_seg()
+{
+	SegParameters *params = SegParametersNewAa();
+	Seg seg;
+	vector<char> s;
+	srand(5);
+	for(unsigned n=0;n<3000;++n) {
+		const int len = rand() % 4 == 0 ? rand() % 2000 : rand() % 300,
+			mode = rand() % 6, k = 1 + rand() % 20, period = 1 + rand() % 8;
+		s.resize(len);
+		for(int i=0;i<len;++i)
+			switch(mode) {
+			case 0: s[i] = rand() % 20; break;
+			case 1: s[i] = rand() % k; break;
+			case 2: s[i] = rand() % 3 ? rand() % k : rand() % 20; break;
+			case 3: s[i] = rand() % 10 == 0 ? 20 + rand() % 5 : (rand() % 2 ? rand() % k : rand() % 20); break;
+			case 4: s[i] = (i / 40) % 2 ? rand() % 20 : (i % period) % k; break;
+			default: s[i] = rand() % 100 < 5 ? 23 : ((i / 30) % 3 ? rand() % 20 : rand() % 2);
+			}
+		test_seg_sequence(seg, params, s);
+	}
+	for(unsigned n=0;n<3;++n) {
+		s.resize(10500 + rand() % 3000);
+		for(size_t i=0;i<s.size();++i)
+			s[i] = rand() % (1 + n);
+		test_seg_sequence(seg, params, s);
+	}
+	SegParametersFree(params);
+}
+
+#endif /* TEST_SEG_H_ */
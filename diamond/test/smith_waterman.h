@@ -0,0 +1,135 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef TEST_SMITH_WATERMAN_H_
+#define TEST_SMITH_WATERMAN_H_
+
+#include <vector>
+#include "test.h"
+#include "../dp/smith_waterman.h"
+
+using std::vector;
+
+struct Sw_score_callback
+{
+	Sw_score_callback(vector<int> &scores):
+		scores_ (scores)
+	{ }
+	template<typename _seq>
+	void operator()(int i, const _seq &seq, int score)
+	{ scores_[i] = score; }
+	vector<int> &scores_;
+};
+
+/* Identical sequences of 200 letters score far beyond the 8 bit range, which
+   ends at 255 minus the bias. These subjects have to be recomputed with 16 bit
+   scores and report the full diagonal, while the unrelated subjects keep their
+   8 bit score. Every kernel the CPU supports is run, with and without SSSE3. */
+
+void test_sw_saturation()
+{
+	namespace po = program_options;
+	const unsigned len = 200, n = 40;
+	vector<Amino_acid> a (len), b (len, Amino_acid(0));
+	int self_score = 0;
+	for(unsigned i=0;i<len;++i) {
+		a[i] = Amino_acid((i*7) % 20);
+		self_score += score_matrix::get().letter_score(a[i], a[i]);
+	}
+	const sequence<const Amino_acid> query (&a[0], len), unrelated (&b[0], len);
+	vector<sequence<const Amino_acid> > subjects;
+	for(unsigned i=0;i<n;++i)
+		subjects.push_back(i%3 == 0 ? unrelated : query);
+	const unsigned identical = n - (n+2)/3;
+	const int saturated = 255 - score_matrix::get().bias();
+
+	const bool ssse3 = po::have_ssse3, avx2 = po::have_avx2, avx512bw = po::have_avx512bw;
+	for(unsigned pass=0;pass<4;++pass) {
+		po::have_avx512bw = avx512bw && pass == 0;
+		po::have_avx2 = avx2 && pass <= 1;
+		po::have_ssse3 = ssse3 && pass <= 2;
+		vector<int> scores (n, -1);
+		Sw_score_callback f (scores);
+		Statistics stats;
+		smith_waterman(query, subjects, 8, 0, po::gap_open + po::gap_extend, po::gap_extend, 0, f, uint8_t(), stats);
+		TEST_CHECK(stats.data_[Statistics::SW_OVERFLOW] == identical);
+		for(unsigned i=0;i<n;++i)
+			if(i%3 == 0)
+				TEST_CHECK(scores[i] < saturated);
+			else
+				TEST_CHECK(scores[i] == self_score);
+	}
+	po::have_ssse3 = ssse3;
+	po::have_avx2 = avx2;
+	po::have_avx512bw = avx512bw;
+}
+
+/* Identical sequences of 3100 letters also saturate the 16 bit lanes. They
+   are reported with the 16 bit maximum and counted, next to an unrelated
+   subject that keeps its score. */
+
+void test_sw_saturation16()
+{
+	namespace po = program_options;
+	const unsigned len = 3100, n = 4;
+	const Amino_acid w = Value_traits<Amino_acid>::from_char('W');
+	vector<Amino_acid> a (len, w), b (len, Amino_acid(0));
+	const sequence<const Amino_acid> query (&a[0], len), unrelated (&b[0], len);
+	vector<sequence<const Amino_acid> > subjects;
+	for(unsigned i=0;i<n;++i)
+		subjects.push_back(i == 0 ? unrelated : query);
+	TEST_CHECK(len * score_matrix::get().letter_score(w, w) > score_traits<int16_t>::max_score);
+
+	vector<int> scores (n, -1);
+	Sw_score_callback f (scores);
+	Statistics stats;
+	smith_waterman(query, subjects, 8, 0, po::gap_open + po::gap_extend, po::gap_extend, 0, f, uint8_t(), stats);
+	TEST_CHECK(stats.data_[Statistics::SW_OVERFLOW] == n - 1);
+	TEST_CHECK(stats.data_[Statistics::SW_OVERFLOW16] == n - 1);
+	TEST_CHECK(scores[0] >= 0 && scores[0] < 255 - score_matrix::get().bias());
+	for(unsigned i=1;i<n;++i)
+		TEST_CHECK(scores[i] == score_traits<int16_t>::max_score);
+}
+
+/* The generic 16 bit profile must agree with the shuffle based one, including
+   lanes that hold no letter. */
+
+void test_sw_profile16()
+{
+#ifdef __SSSE3__
+	if(!program_options::have_ssse3)
+		return;
+	typedef score_vector<int16_t,128> sv;
+	int16_t letters[8] __attribute__ ((aligned (16)));
+	for(unsigned i=0;i<32;++i) {
+		for(unsigned j=0;j<8;++j)
+			letters[j] = (i + 5*j) % 26 == 25 ? -1 : (i + 5*j) % 26;
+		const __m128i seq (_mm_load_si128((const __m128i*)letters));
+		for(unsigned a=0;a<25;++a) {
+			sv x (0), y (0);
+			x.set_generic(a, seq);
+			y.set_ssse3(a, seq);
+			TEST_CHECK(x.cmpeq(y) == 0xffff);
+		}
+	}
+#endif
+}
+
+#endif /* TEST_SMITH_WATERMAN_H_ */
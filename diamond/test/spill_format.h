@@ -0,0 +1,130 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef TEST_SPILL_FORMAT_H_
+#define TEST_SPILL_FORMAT_H_
+
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+#include "test.h"
+#include "../basic/match.h"
+#include "../util/async_buffer.h"
+
+using std::vector;
+
+/* Blocks of trace points written through one Spill_format have to decode,
+   block by block as Async_buffer::load reads a bin, into the sorted blocks.
+   Query ids go up and down between blocks and subjects repeat within a
+   query. */
+
+template<typename _locr, typename _locl>
+void test_spill_blocks(uint64_t max_subject)
+{
+	typedef hit<_locr,_locl> Hit;
+	Spill_format<Hit> encoder, decoder;
+	vector<Hit> expected;
+	vector<char> buf;
+	vector<size_t> records, bytes;
+	for(unsigned block=0;block<20;++block) {
+		vector<Hit> v;
+		const unsigned n = rand() % 3000, queries = 1 + rand() % 1000, query_base = rand() % 2;
+		for(unsigned i=0;i<n;++i)
+			v.push_back(Hit (query_base + rand() % queries,
+					_locr(((uint64_t(rand()) << 31) ^ uint64_t(rand())) % max_subject),
+					_locl(rand())));
+		encoder.encode(v, buf);
+		expected.insert(expected.end(), v.begin(), v.end());
+		records.push_back(n);
+		bytes.push_back(buf.size());
+	}
+	vector<Hit> out (expected.size());
+	const char *ptr = buf.data();
+	Hit *dst = out.data();
+	for(unsigned block=0;block<records.size();++block) {
+		ptr = decoder.decode(ptr, dst, records[block]);
+		TEST_CHECK(ptr == buf.data() + bytes[block]);
+		dst += records[block];
+	}
+	for(size_t i=0;i<out.size();++i)
+		TEST_CHECK(out[i].query_ == expected[i].query_
+				&& (uint64_t)out[i].subject_ == (uint64_t)expected[i].subject_
+				&& out[i].seed_offset_ == expected[i].seed_offset_);
+}
+
+struct Test_hit_less
+{
+	template<typename _hit>
+	bool operator()(const _hit &lhs, const _hit &rhs) const
+	{
+		if(lhs.query_ != rhs.query_)
+			return lhs.query_ < rhs.query_;
+		if((uint64_t)lhs.subject_ != (uint64_t)rhs.subject_)
+			return (uint64_t)lhs.subject_ < (uint64_t)rhs.subject_;
+		return lhs.seed_offset_ < rhs.seed_offset_;
+	}
+};
+
+/* Trace points pushed through an Async_buffer come back from the deflated
+   bin files, each in its bin. */
+
+void test_spill_buffer()
+{
+	typedef hit<uint32_t,uint8_t> Hit;
+	const unsigned queries = 5000, bins = 3;
+	vector<Hit> expected;
+	Async_buffer<Hit> buffer (queries, program_options::tmpdir, bins);
+	{
+		Async_buffer<Hit>::Iterator it (buffer);
+		for(unsigned i=0;i<300000;++i) {
+			const Hit h (rand() % (queries*6), rand(), uint8_t(rand()));
+			expected.push_back(h);
+			it.push(h);
+		}
+	}
+	buffer.close();
+	TEST_CHECK(buffer.size() == expected.size());
+	vector<Hit> out, v;
+	for(unsigned bin=0;bin<bins;++bin) {
+		buffer.load(v, bin);
+		for(size_t i=0;i<v.size();++i)
+			TEST_CHECK(v[i] / ((queries + bins - 1) / bins) == bin);
+		out.insert(out.end(), v.begin(), v.end());
+	}
+	std::sort(expected.begin(), expected.end(), Test_hit_less ());
+	std::sort(out.begin(), out.end(), Test_hit_less ());
+	TEST_CHECK(out.size() == expected.size());
+	for(size_t i=0;i<out.size() && i<expected.size();++i)
+		TEST_CHECK(out[i].query_ == expected[i].query_
+				&& (uint64_t)out[i].subject_ == (uint64_t)expected[i].subject_
+				&& out[i].seed_offset_ == expected[i].seed_offset_);
+}
+
+void test_spill_format()
+{
+	srand(1);
+	test_spill_blocks<uint32_t,uint8_t>(uint64_t(1) << 32);
+	test_spill_blocks<uint32_t,uint16_t>(1000);
+	test_spill_blocks<uint64_t,uint8_t>(uint64_t(1) << 40);
+	test_spill_blocks<uint64_t,uint32_t>(uint64_t(1) << 36);
+	test_spill_buffer();
+}
+
+#endif /* TEST_SPILL_FORMAT_H_ */
@@ -0,0 +1,72 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <iostream>
+
+using std::cerr;
+using std::endl;
+
+/* Minimal support for the self tests run by "diamond check". A test is a
+   function that reports failed conditions through TEST_CHECK. */
+
+struct Test_state
+{
+	Test_state():
+		failed (0)
+	{ }
+	void check(bool cond, const char *file, int line, const char *expr)
+	{
+		if(cond)
+			return;
+		cerr << file << ':' << line << ": check failed: " << expr << endl;
+		++failed;
+	}
+	unsigned failed;
+} test_state;
+
+#define TEST_CHECK(cond) test_state.check((cond), __FILE__, __LINE__, #cond)
+
+typedef void (*Test_function)();
+
+struct Test_case
+{
+	const char *name;
+	Test_function f;
+};
+
+bool run_tests(const Test_case *begin, const Test_case *end)
+{
+	unsigned failed_tests = 0;
+	for(const Test_case *i=begin;i<end;++i) {
+		const unsigned failed = test_state.failed;
+		i->f();
+		const bool ok = test_state.failed == failed;
+		cerr << i->name << (ok ? " ... ok" : " ... FAILED") << endl;
+		if(!ok)
+			++failed_tests;
+	}
+	cerr << (end - begin - failed_tests) << " of " << (end - begin) << " tests passed." << endl;
+	return failed_tests == 0;
+}
+
+#endif /* TEST_H_ */
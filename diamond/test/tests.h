@@ -0,0 +1,63 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef TESTS_H_
+#define TESTS_H_
+
+#include "test.h"
+#include "smith_waterman.h"
+#include "floating_sw.h"
+#include "align_ungapped.h"
+#include "radix_sort.h"
+#include "spill_format.h"
+#include "seed_freq.h"
+#include "filter_table.h"
+#include "seg.h"
+#include "translate.h"
+
+/* The self tests, run by the hidden "diamond check" command and "make check". */
+
+const Test_case tests[] = {
+	{ "sw_saturation", test_sw_saturation },
+	{ "sw_saturation16", test_sw_saturation16 },
+	{ "sw_profile16", test_sw_profile16 },
+	{ "floating_sw_avx2", test_floating_sw_avx2 },
+	{ "ungapped_batch", test_ungapped_batch },
+	{ "radix_sort", test_radix_sort },
+	{ "spill_format", test_spill_format },
+	{ "seed_freq", test_seed_freq },
+	{ "filter_table", test_filter_table },
+	{ "seg", test_seg },
+	{ "translate", test_translate }
+};
+
+bool run_tests()
+{ return run_tests(tests, tests + sizeof(tests)/sizeof(tests[0])); }
+
+/* Micro-benchmarks, run by the hidden "diamond benchmark" command. */
+
+void run_benchmarks()
+{
+	benchmark_filter_table();
+	benchmark_radix_sort();
+	benchmark_counting_sort();
+}
+
+#endif /* TESTS_H_ */
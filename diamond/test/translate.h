@@ -0,0 +1,94 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef TEST_TRANSLATE_H_
+#define TEST_TRANSLATE_H_
+
+#include <stdlib.h>
+#include <vector>
+#include "test.h"
+#include "../basic/translate.h"
+
+using std::vector;
+
+/* Frame_translator against Translator::translate and computeGoodFrames for
+   one sequence. Frames are written into buffers with a guard behind them. */
+void test_translate_seq(Frame_translator &translate, const vector<Nucleotide> &seq, unsigned run_len)
+{
+	const size_t len = seq.size(), guard = 32;
+	const Amino_acid fill = 0x7F;
+	vector<Amino_acid> expected[6], out[6];
+	Amino_acid *frames[6];
+	for(unsigned j=0;j<6;++j) {
+		const size_t l = len < 2 ? 0 : (len - j%3) / 3;
+		expected[j].resize(l);
+		out[j].assign(l + guard, fill);
+		frames[j] = out[j].data();
+	}
+	const unsigned good = translate(seq.data(), len, frames, run_len);
+	if(len < 2) {
+		TEST_CHECK(good == 0);
+		return;
+	}
+	Translator::translate(seq, expected);
+	TEST_CHECK(good == Translator::computeGoodFrames(expected, run_len));
+	for(unsigned j=0;j<6;++j) {
+		const size_t l = expected[j].size();
+		TEST_CHECK(std::equal(expected[j].begin(), expected[j].end(), out[j].begin()));
+		for(size_t k=l;k<l+guard;++k)
+			TEST_CHECK(out[j][k] == fill);
+	}
+}
+
+/* All lengths up to 400, so that every length mod 3 and mod 16 meets the
+   shuffles, for uniform and AT rich (stop rich) sequences with and without N,
+   with run lengths around the stop free runs that occur, with and without
+   SSSE3. */
+
+void test_translate()
+{
+	namespace po = program_options;
+	const bool ssse3 = po::have_ssse3;
+	const unsigned run_lens[] = { 1, 3, 8, 20, 40 };
+	srand(1);
+	Frame_translator translate;
+	for(unsigned len=0;len<=400;++len)
+		for(unsigned composition=0;composition<4;++composition) {
+			vector<Nucleotide> seq (len);
+			for(unsigned i=0;i<len;++i) {
+				const int r = rand() % 100;
+				if(composition % 2 == 1 && r < 5)
+					seq[i] = 4;
+				else if(composition >= 2)
+					seq[i] = r < 40 ? 0 : (r < 80 ? 3 : rand() % 4);
+				else
+					seq[i] = rand() % 4;
+			}
+			for(unsigned k=0;k<2;++k) {
+				po::have_ssse3 = ssse3 && k == 1;
+				test_translate_seq(translate, seq, po::get_run_len(len/3));
+				for(unsigned r=0;r<sizeof(run_lens)/sizeof(run_lens[0]);++r)
+					test_translate_seq(translate, seq, run_lens[r]);
+			}
+		}
+	po::have_ssse3 = ssse3;
+}
+
+#endif /* TEST_TRANSLATE_H_ */
@@ -22,20 +22,22 @@ Author: Benjamin Buchfink
 #define ASYNC_BUFFER_H_
 
 #include <vector>
+#include <deque>
+#include <numeric>
 #include <boost/thread.hpp>
-#include <boost/lockfree/queue.hpp>
+#include <boost/atomic.hpp>
 #include <boost/iostreams/device/file_descriptor.hpp>
 #include <boost/iostreams/device/file.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
 #include <boost/ptr_container/ptr_vector.hpp>
+#include <zlib.h>
 
 namespace io = boost::iostreams;
 
 using std::vector;
 using std::string;
 using std::endl;
-using boost::lockfree::queue;
 using boost::thread;
 using boost::ptr_vector;
 
@@ -46,7 +48,21 @@ struct Buffer_file_read_exception : public diamond_exception
 	{ }
 };
 
-const unsigned async_buffer_max_bins = 4;
+/* Encoding of the records spilled by Async_buffer, one block at a time.
+   encode() runs on the writer thread and may reorder the block. Each bin gets
+   its own instance, so a format may carry state from one block to the next. */
+
+template<typename _t>
+struct Spill_format
+{
+	void encode(vector<_t> &v, vector<char> &out)
+	{ out.insert(out.end(), reinterpret_cast<const char*>(v.data()), reinterpret_cast<const char*>(v.data() + v.size())); }
+	const char* decode(const char *ptr, _t *dst, size_t n)
+	{
+		memcpy(dst, ptr, n*sizeof(_t));
+		return ptr + n*sizeof(_t);
+	}
+};
 
 template<typename _t>
 struct Async_buffer
@@ -57,22 +73,31 @@ struct Async_buffer
 	Async_buffer(size_t input_count, const string &tmpdir, unsigned bins):
 		bins_ (bins),
 		bin_size_ ((input_count + bins_ - 1) / bins_),
+		buffer_size_ (std::max(size_t(min_buffer_size), size_t(max_buffer_size)*4/bins_)),
+		size_ (bins_),
+		bytes_ (bins_),
+		encoded_bytes_ (bins_),
+		format_ (bins_),
 		done_ (false),
 		tmpdir_ (tmpdir),
-		push_count_ (0)
+		push_count_ (0),
+		writer_failed_ (false),
+		high_water_ (0),
+		queued_ (bins_),
+		bin_high_water_ (bins_)
 	{
 		log_stream << "Async_buffer() " << input_count << ',' << bin_size_ << endl;
 		for(unsigned i=0;i<bins_;++i) {
 			//out_[i].push(io::gzip_compressor());
 			out_.push_back(new Output_stream(get_file_name(i)));
 		}
-		memset(size_, 0, sizeof(size_));
 		writer_thread_  = new thread(writer, this);
 	}
 
 	struct Iterator
 	{
 		Iterator(Async_buffer &parent):
+			buffer_ (parent.bins_),
 			parent_ (&parent)
 		{
 			for(unsigned i=0;i<parent_->bins_;++i)
@@ -84,29 +109,39 @@ struct Async_buffer
 			const unsigned bin = x / parent_->bin_size_;
 			assert(bin < parent_->bins());
 			buffer_[bin]->push_back(x);
-			if(buffer_[bin]->size() == buffer_size) {
-				parent_->out_queue_[bin].push(buffer_[bin]);
+			if(buffer_[bin]->size() == parent_->buffer_size_) {
+				parent_->enqueue(bin, buffer_[bin]);
 				buffer_[bin] = new vector<_t>;
 			}
 		}
 		~Iterator()
 		{
 			for(unsigned bin=0;bin<parent_->bins_;++bin)
-				parent_->out_queue_[bin].push(buffer_[bin]);
+				parent_->enqueue(bin, buffer_[bin]);
 		}
 	private:
-		vector<_t> *buffer_[async_buffer_max_bins];
+		vector<vector<_t>*> buffer_;
 		Async_buffer *parent_;
 	};
 
 	void close()
 	{
-		done_ = true;
+		{
+			boost::lock_guard<boost::mutex> lock (mtx_);
+			done_ = true;
+		}
+		not_empty_.notify_one();
 		writer_thread_->join();
 		delete writer_thread_;
 		out_.clear();
 		for(unsigned i=0;i<bins_;++i)
-			log_stream << "Queue " << i << " status " << out_queue_[i].empty() << endl;
+			log_stream << "Queue " << i << " high-water mark " << bin_high_water_[i] << " buffers" << endl;
+		log_stream << "Queue high-water mark " << high_water_ << '/' << max_queue_depth << " buffers" << endl;
+		const size_t n = size(),
+			bytes = std::accumulate(bytes_.begin(), bytes_.end(), size_t(0)),
+			encoded = std::accumulate(encoded_bytes_.begin(), encoded_bytes_.end(), size_t(0));
+		log_stream << "Spilled " << n << " records, " << bytes << " bytes (" << (n > 0 ? double(bytes)/n : 0) << " bytes/record, "
+				<< (n > 0 ? double(encoded)/n : 0) << " encoded, raw " << sizeof(_t) << ")" << endl;
 		log_stream << "Async_buffer.close() " << push_count_ << endl;
 	}
 
@@ -115,10 +150,28 @@ struct Async_buffer
 		log_stream << "Async_buffer.load() " << size_[i] << endl;
 		data.resize(size_[i]);
 		if(size_[i] > 0) {
+			vector<char> buf (bytes_[i]), block;
 			Input_stream f (get_file_name(i));
-			const size_t n = f.read(data.data(), size_[i]);
-			if(n != size_[i])
-				throw Buffer_file_read_exception(f.file_name.c_str(), size_[i], n);
+			const size_t n = f.read(buf.data(), bytes_[i]);
+			if(n != bytes_[i])
+				throw Buffer_file_read_exception(f.file_name.c_str(), bytes_[i], n);
+			Spill_format<_t> format;
+			const char *ptr = buf.data(), *end = buf.data() + buf.size();
+			size_t count = 0;
+			while(ptr < end) {
+				const size_t records = get_varint(ptr), encoded = get_varint(ptr), deflated = get_varint(ptr);
+				uLongf len = encoded;
+				block.resize(encoded);
+				if(count + records > size_[i] || ptr + deflated > end
+						|| uncompress(reinterpret_cast<Bytef*>(block.data()), &len, reinterpret_cast<const Bytef*>(ptr), deflated) != Z_OK
+						|| len != encoded
+						|| format.decode(block.data(), data.data() + count, records) != block.data() + encoded)
+					THROW_EXCEPTION(file_io_exception, f.file_name);
+				ptr += deflated;
+				count += records;
+			}
+			if(count != size_[i])
+				THROW_EXCEPTION(file_io_exception, f.file_name);
 		}
 		remove(get_file_name(i).c_str());
 	}
@@ -126,49 +179,101 @@ struct Async_buffer
 	unsigned bins() const
 	{ return bins_; }
 
+	size_t size() const
+	{ return std::accumulate(size_.begin(), size_.end(), size_t(0)); }
+
 private:
 
-	enum { buffer_size = 65536 };
+	enum { max_buffer_size = 65536, min_buffer_size = 4096, max_queue_depth = 64 };
 
 	string get_file_name(unsigned i) const
 	{ return tmpdir_ + "/diamond_" + boost::to_string(program_options::magic_number) + "_" + boost::to_string(i) + ".tmp"; }
 
-	void flush_queues()
+	/* Producers block while max_queue_depth buffers are waiting to be written,
+	   so the memory held by the queue stays bounded when the disk falls behind. */
+
+	void enqueue(unsigned bin, vector<_t> *v)
 	{
-		vector<_t> *v;
-		for(unsigned i=0;i<bins_;++i)
-			while(out_queue_[i].pop(v)) {
-				out_[i].write(v->data(), v->size());
-				size_[i] += v->size();
-				delete v;
-			}
+		{
+			boost::unique_lock<boost::mutex> lock (mtx_);
+			while(queue_.size() >= max_queue_depth && !writer_failed_)
+				not_full_.wait(lock);
+			queue_.push_back(std::make_pair(bin, v));
+			high_water_ = std::max(high_water_, queue_.size());
+			bin_high_water_[bin] = std::max(bin_high_water_[bin], ++queued_[bin]);
+		}
+		not_empty_.notify_one();
 	}
 
 	static void writer(Async_buffer *me)
 	{
 		try {
-			while(!me->done_ && !exception_state()) {
-				me->flush_queues();
-				boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+			while(true) {
+				std::pair<unsigned,vector<_t>*> item;
+				{
+					boost::unique_lock<boost::mutex> lock (me->mtx_);
+					while(me->queue_.empty() && !me->done_)
+						me->not_empty_.wait(lock);
+					if(me->queue_.empty())
+						break;
+					item = me->queue_.front();
+					me->queue_.pop_front();
+					--me->queued_[item.first];
+				}
+				me->not_full_.notify_all();
+				me->encode_buffer_.clear();
+				me->format_[item.first].encode(*item.second, me->encode_buffer_);
+				me->write_block(item.first, item.second->size());
+				me->size_[item.first] += item.second->size();
+				delete item.second;
 			}
-			me->flush_queues();
 		} catch(std::exception& e) {
 			exception_state.set(e);
+			{
+				boost::lock_guard<boost::mutex> lock (me->mtx_);
+				me->writer_failed_ = true;
+			}
+			me->not_full_.notify_all();
 		}
 	}
 
+	/* The encoded block is deflated at level 1 and written behind its record
+	   count, encoded and deflated sizes. */
+
+	void write_block(unsigned bin, size_t records)
+	{
+		if(encode_buffer_.empty())
+			return;
+		uLongf len = compressBound(encode_buffer_.size());
+		deflate_buffer_.resize(len);
+		if(compress2(reinterpret_cast<Bytef*>(deflate_buffer_.data()), &len, reinterpret_cast<const Bytef*>(encode_buffer_.data()), encode_buffer_.size(), 1) != Z_OK)
+			THROW_EXCEPTION(file_io_write_exception, get_file_name(bin));
+		header_buffer_.clear();
+		put_varint(header_buffer_, records);
+		put_varint(header_buffer_, encode_buffer_.size());
+		put_varint(header_buffer_, len);
+		out_[bin].write(header_buffer_.data(), header_buffer_.size());
+		out_[bin].write(deflate_buffer_.data(), len);
+		bytes_[bin] += header_buffer_.size() + len;
+		encoded_bytes_[bin] += encode_buffer_.size();
+	}
+
 	const unsigned bins_, bin_size_;
+	const size_t buffer_size_;
 	ptr_vector<Output_stream> out_;
-#ifdef NDEBUG
-	queue<vector<_t>*> out_queue_[async_buffer_max_bins];
-#else
-	queue<vector<_t>*,boost::lockfree::capacity<128> > out_queue_[async_buffer_max_bins];
-#endif
-	size_t size_[async_buffer_max_bins];
+	std::deque<std::pair<unsigned,vector<_t>*> > queue_;
+	boost::mutex mtx_;
+	boost::condition_variable not_empty_, not_full_;
+	vector<size_t> size_, bytes_, encoded_bytes_;
+	vector<Spill_format<_t> > format_;
+	vector<char> encode_buffer_, deflate_buffer_, header_buffer_;
 	thread *writer_thread_;
 	bool done_;
 	const string tmpdir_;
 	boost::atomic<size_t> push_count_;
+	bool writer_failed_;
+	size_t high_water_;
+	vector<size_t> queued_, bin_high_water_;
 
 };
 
@@ -24,11 +24,16 @@ Author: Benjamin Buchfink
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <boost/iostreams/device/file_descriptor.hpp>
 #include <boost/iostreams/device/file.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
 #include "../basic/exceptions.h"
+#include "gzip_reader.h"
 
 namespace io = boost::iostreams;
 
@@ -50,25 +55,67 @@ struct File_write_exception : public diamond_exception
 	{ }
 };
 
+struct Mapped_file
+{
+
+	Mapped_file(const string &file_name):
+		file_name (file_name)
+	{
+		const int fd = open(file_name.c_str(), O_RDONLY);
+		if(fd < 0)
+			THROW_EXCEPTION(file_open_exception, file_name);
+		struct stat st;
+		if(fstat(fd, &st) != 0) {
+			::close(fd);
+			THROW_EXCEPTION(file_io_exception, file_name);
+		}
+		size_ = st.st_size;
+		// Private writable mapping: pages are shared with the page cache until written (e.g. by seed masking).
+		data_ = size_ > 0 ? static_cast<char*>(mmap(0, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0)) : 0;
+		::close(fd);
+		if(data_ == MAP_FAILED)
+			THROW_EXCEPTION(file_io_exception, file_name);
+	}
+
+	~Mapped_file()
+	{ if(data_) munmap(data_, size_); }
+
+	char* data(size_t offset) const
+	{ return data_ + offset; }
+
+	size_t size() const
+	{ return size_; }
+
+	void discard(const void *ptr, size_t n) const
+	{
+		// Drop private copies of modified pages so that the next access sees the file contents again.
+		const size_t page = sysconf(_SC_PAGESIZE);
+		const size_t begin = (static_cast<const char*>(ptr) - data_) / page * page;
+		const size_t end = std::min((static_cast<const char*>(ptr) - data_ + n + page - 1) / page * page, size_);
+		if(end > begin)
+			madvise(data_ + begin, end - begin, MADV_DONTNEED);
+	}
+
+	const string file_name;
+
+private:
+
+	Mapped_file(const Mapped_file&);
+	Mapped_file& operator=(const Mapped_file&);
+
+	char *data_;
+	size_t size_;
+
+};
+
 struct Input_stream : public io::filtering_istream
 {
 
 	Input_stream(const string &file_name, bool gzipped = false):
 		file_name (file_name)
 	{
-		if(gzipped) {
-			FILE *f = fopen(file_name.c_str(), "rb");
-			if(f == 0)
-				THROW_EXCEPTION(file_open_exception, file_name);
-			unsigned char id[2];
-			if(fread(id, 1, 2, f) != 2)
-				THROW_EXCEPTION(file_io_exception, file_name);
-			fclose(f);
-			if(id[0] == 0x1f && id[1] == 0x8b) {
-				log_stream << "Detected gzip compressed file " << file_name << endl;
-				this->push(io::gzip_decompressor ());
-			}
-		}
+		if(gzipped && is_gzip(file_name))
+			this->push(io::gzip_decompressor ());
 		io::file_source f (file_name, std::ios_base::in | std::ios_base::binary);
 		if(!f.is_open())
 			THROW_EXCEPTION(file_open_exception, file_name);
@@ -101,6 +148,18 @@ struct Input_stream : public io::filtering_istream
 			THROW_EXCEPTION(file_io_exception, file_name);
 	}
 
+	template<class _t>
+	_t* map(const Mapped_file &f, size_t &size)
+	{
+		if(read(&size, 1) != 1)
+			THROW_EXCEPTION(file_io_exception, file_name);
+		const size_t offset = this->tellg();
+		if(offset + size * sizeof(_t) > f.size() || offset % __alignof__(_t) != 0)
+			THROW_EXCEPTION(file_io_exception, file_name);
+		this->seekg(offset + size * sizeof(_t));
+		return reinterpret_cast<_t*>(f.data(offset));
+	}
+
 	void close()
 	{
 		this->set_auto_close(true);
@@ -110,6 +169,22 @@ struct Input_stream : public io::filtering_istream
 	void remove() const
 	{ ::remove(file_name.c_str()); }
 
+	static bool is_gzip(const string &file_name)
+	{
+		FILE *f = fopen(file_name.c_str(), "rb");
+		if(f == 0)
+			THROW_EXCEPTION(file_open_exception, file_name);
+		unsigned char id[2];
+		if(fread(id, 1, 2, f) != 2)
+			THROW_EXCEPTION(file_io_exception, file_name);
+		fclose(f);
+		if(id[0] == 0x1f && id[1] == 0x8b) {
+			log_stream << "Detected gzip compressed file " << file_name << endl;
+			return true;
+		}
+		return false;
+	}
+
 	const string file_name;
 
 };
@@ -251,6 +326,67 @@ private:
 
 };
 
+/* Reads a text file in large blocks. The unconsumed tail of a block is
+ * kept for the next fetch, and the buffer grows if it holds no complete
+ * record. Gzip input is inflated ahead on a separate thread. */
+
+struct Input_buffer
+{
+
+	Input_buffer(const string& file_name, bool gzipped=false):
+		gzip_ (gzipped && Input_stream::is_gzip(file_name) ? new Gzip_reader (file_name) : 0),
+		stream_ (gzip_.get() ? 0 : new Input_stream (file_name)),
+		data_ (block_size),
+		begin_ (0),
+		end_ (0),
+		eof_ (false)
+	{ }
+
+	const char* begin() const
+	{ return data_.data() + begin_; }
+
+	const char* end() const
+	{ return data_.data() + end_; }
+
+	/* True if the buffer holds the rest of the file. */
+	bool eof() const
+	{ return eof_; }
+
+	void consume(const char *p)
+	{ begin_ = p - data_.data(); }
+
+	void fetch()
+	{
+		memmove(data_.data(), data_.data() + begin_, end_ - begin_);
+		end_ -= begin_;
+		begin_ = 0;
+		if(end_ == data_.size())
+			data_.resize(data_.size() * 2);
+		const size_t n = data_.size() - end_;
+		const size_t r = gzip_.get() ? gzip_->read(data_.data() + end_, n) : stream_->read(data_.data() + end_, n);
+		end_ += r;
+		eof_ = r < n;
+	}
+
+	/* Number of threads for inflating gzip input. */
+	void set_threads(unsigned n)
+	{
+		if(gzip_.get())
+			gzip_->set_threads(n);
+	}
+
+private:
+
+	enum { block_size = 1<<26 };
+
+	auto_ptr<Gzip_reader> gzip_;
+	auto_ptr<Input_stream> stream_;
+	vector<char> data_;
+	size_t begin_, end_;
+	bool eof_;
+
+};
+
 struct Buffered_ostream
 {
 
@@ -21,9 +21,10 @@ Author: Benjamin Buchfink
 #ifndef COMPLEXITY_FILTER_H_
 #define COMPLEXITY_FILTER_H_
 
-#include "../algo/blast/core/blast_seg.h"
-#include "../algo/blast/core/blast_filter.h"
+#include <boost/thread/tss.hpp>
 #include "../basic/value.h"
+#include "util.h"
+#include "seg.h"
 
 template<class _val>
 struct Complexity_filter
@@ -36,28 +37,16 @@ template<>
 struct Complexity_filter<Amino_acid>
 {
 
-	Complexity_filter()
-	{ blast_seg_ = SegParametersNewAa(); }
-
-	~Complexity_filter()
-	{ SegParametersFree(blast_seg_); }
-
 	unsigned filter(sequence<Amino_acid> seq) const
 	{
-		BlastSeqLoc *seg_locs;
-		SeqBufferSeg ((uint8_t*) seq.data(), seq.length(), 0, blast_seg_, &seg_locs);
+		Tls<Seg> seg (seg_ptr);
+		const vector<Seg::Segment> &segs ((*seg)((const char*)seq.data(), seq.length()));
 		unsigned nMasked = 0;
-
-		if(seg_locs) {
-			BlastSeqLoc *l = seg_locs;
-			do {
-				for(signed i=l->ssr->left;i<=l->ssr->right;i++) {
-					nMasked++;
-					seq[i] = Value_traits<Amino_acid>::MASK_CHAR;
-				}
-			} while((l=l->next) != 0);
-			BlastSeqLocFree(seg_locs);
-		}
+		for(vector<Seg::Segment>::const_iterator l=segs.begin();l!=segs.end();++l)
+			for(signed i=l->begin;i<=l->end;i++) {
+				nMasked++;
+				seq[i] = Value_traits<Amino_acid>::MASK_CHAR;
+			}
 		return nMasked;
 	}
 
@@ -73,12 +62,12 @@ struct Complexity_filter<Amino_acid>
 
 private:
 
-	SegParameters *blast_seg_;
-
 	static const Complexity_filter instance;
+	static boost::thread_specific_ptr<Seg> seg_ptr;
 
 };
 
 const Complexity_filter<Amino_acid> Complexity_filter<Amino_acid>::instance;
+boost::thread_specific_ptr<Seg> Complexity_filter<Amino_acid>::seg_ptr;
 
 #endif /* COMPLEXITY_FILTER_H_ */
@@ -0,0 +1,152 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef FILTER_TABLE_H_
+#define FILTER_TABLE_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <emmintrin.h>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include "../basic/const.h"
+#include "hash_function.h"
+
+/* Maps the partition offsets of masked seeds to their position filter
+ * treshold. Each seed partition owns a power of two number of cache line
+ * buckets holding up to 12 keys, which are compared in one go with SSE2.
+ * A full bucket continues into the next one. The buckets of all
+ * partitions of an index chunk come from one allocation, and a partition
+ * is only written by the thread building it, so no locking is needed.
+ * Tresholds of 0 are never stored; they read as absent. */
+
+struct Filter_table
+{
+
+	enum { bucket_keys = 12 };
+
+	struct Bucket
+	{
+		uint32_t key[bucket_keys];
+		uint8_t value[bucket_keys];
+		uint32_t n;
+	} __attribute__((aligned(64)));
+
+	Filter_table()
+	{
+		memset(buckets_, 0, sizeof(buckets_));
+		memset(mask_, 0, sizeof(mask_));
+	}
+
+	/* Allocates the tables for partitions [begin, end), sized for
+	 * counts[p] keys each. Tables of partitions outside the range are
+	 * kept; a block covering part of the range is released. */
+	void init(unsigned begin, unsigned end, const unsigned *counts)
+	{
+		for(size_t i=0;i<blocks_.size();)
+			if(blocks_[i].begin < end && blocks_[i].end > begin)
+				blocks_.erase(blocks_.begin() + i);
+			else
+				++i;
+		size_t total = 0;
+		for(unsigned p=begin;p<end;++p) {
+			size_t n = 1;
+			while(n * (bucket_keys*2/3) < counts[p])
+				n <<= 1;
+			mask_[p] = n - 1;
+			total += n;
+		}
+		blocks_.push_back(new Block (begin, end, total));
+		Bucket *b = blocks_.back().data;
+		for(unsigned p=begin;p<end;++p) {
+			buckets_[p] = b;
+			b += mask_[p] + 1;
+		}
+	}
+
+	/* Clears the table of partition p. Called by the thread filling it. */
+	void clear(unsigned p)
+	{
+		for(size_t i=0;i<=mask_[p];++i)
+			buckets_[p][i].n = 0;
+	}
+
+	void insert(unsigned p, uint32_t key, uint8_t value)
+	{
+		if(value == 0)
+			return;
+		size_t i = murmur_hash()(key) & mask_[p];
+		while(buckets_[p][i].n == bucket_keys)
+			i = (i + 1) & mask_[p];
+		Bucket &b = buckets_[p][i];
+		b.key[b.n] = key;
+		b.value[b.n] = value;
+		++b.n;
+	}
+
+	/* Returns the treshold stored for key in partition p, 0 if none. */
+	unsigned get(unsigned p, uint32_t key) const
+	{
+		const __m128i k (_mm_set1_epi32(key));
+		size_t i = murmur_hash()(key) & mask_[p];
+		while(true) {
+			const Bucket &b = buckets_[p][i];
+			const __m128i m0 (_mm_cmpeq_epi32(k, _mm_load_si128((const __m128i*)b.key))),
+				m1 (_mm_cmpeq_epi32(k, _mm_load_si128((const __m128i*)(b.key+4)))),
+				m2 (_mm_cmpeq_epi32(k, _mm_load_si128((const __m128i*)(b.key+8))));
+			const unsigned match = _mm_movemask_epi8(_mm_packs_epi16(_mm_packs_epi32(m0, m1), _mm_packs_epi32(m2, m2)))
+				& ((1u << b.n) - 1);
+			if(match)
+				return b.value[__builtin_ctz(match)];
+			if(b.n < bucket_keys)
+				return 0;
+			i = (i + 1) & mask_[p];
+		}
+	}
+
+private:
+
+	struct Block
+	{
+		Block(unsigned begin, unsigned end, size_t n):
+			begin (begin),
+			end (end)
+		{
+			void *p;
+			if(posix_memalign(&p, sizeof(Bucket), n * sizeof(Bucket)) != 0)
+				throw std::bad_alloc ();
+			data = (Bucket*)p;
+		}
+		~Block()
+		{ free(data); }
+		unsigned begin, end;
+		Bucket *data;
+	};
+
+	Filter_table(const Filter_table&);
+	Filter_table& operator=(const Filter_table&);
+
+	Bucket *buckets_[Const::seedp];
+	size_t mask_[Const::seedp];
+	boost::ptr_vector<Block> blocks_;
+
+};
+
+#endif /* FILTER_TABLE_H_ */
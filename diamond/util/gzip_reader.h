@@ -0,0 +1,324 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef GZIP_READER_H_
+#define GZIP_READER_H_
+
+#include <stdio.h>
+#include <string.h>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <zlib.h>
+#include <boost/thread.hpp>
+#include "../basic/exceptions.h"
+
+using std::vector;
+using std::string;
+using std::auto_ptr;
+using boost::thread;
+
+/* Decompresses a gzip file on a dedicated thread, which hands blocks of
+ * output to the reader through a bounded queue. Members of a BGZF file
+ * carry their compressed size, so batches of them are split up front and
+ * inflated in parallel; other files are inflated as one stream, member
+ * after member. The parallel inflate leaves one thread to the reader by
+ * default, a background reader can lower the count with set_threads(). */
+
+struct Gzip_reader
+{
+
+	Gzip_reader(const string &file_name):
+		file_name (file_name),
+		f_ (fopen(file_name.c_str(), "rb")),
+		block_ (0),
+		pos_ (0),
+		threads_ (std::max(1u, program_options::threads() - 1)),
+		done_ (false),
+		failed_ (false),
+		stop_ (false)
+	{
+		if(f_ == 0)
+			THROW_EXCEPTION(file_open_exception, file_name);
+		thread_ = new thread(run, this);
+	}
+
+	~Gzip_reader()
+	{
+		{
+			boost::lock_guard<boost::mutex> lock (mtx_);
+			stop_ = true;
+		}
+		not_full_.notify_all();
+		thread_->join();
+		delete thread_;
+		delete block_;
+		for(std::deque<vector<char>*>::iterator i=queue_.begin();i!=queue_.end();++i)
+			delete *i;
+		fclose(f_);
+	}
+
+	size_t read(char *ptr, size_t count)
+	{
+		size_t n = 0;
+		while(n < count) {
+			if(block_ == 0 || pos_ == block_->size()) {
+				delete block_;
+				pos_ = 0;
+				if((block_ = pop()) == 0)
+					break;
+			}
+			const size_t k = std::min(count - n, block_->size() - pos_);
+			memcpy(ptr + n, block_->data() + pos_, k);
+			pos_ += k;
+			n += k;
+		}
+		return n;
+	}
+
+	void set_threads(unsigned n)
+	{
+		boost::lock_guard<boost::mutex> lock (mtx_);
+		threads_ = std::max(1u, n);
+	}
+
+	const string file_name;
+
+private:
+
+	enum { block_size = 1<<24, max_queue_depth = 4, header_size = 12, max_bgzf_block = 65536 };
+
+	vector<char>* pop()
+	{
+		vector<char> *v;
+		{
+			boost::unique_lock<boost::mutex> lock (mtx_);
+			while(queue_.empty() && !done_)
+				not_empty_.wait(lock);
+			if(queue_.empty()) {
+				if(failed_)
+					exception_state.sync();
+				return 0;
+			}
+			v = queue_.front();
+			queue_.pop_front();
+		}
+		not_full_.notify_one();
+		return v;
+	}
+
+	bool push(vector<char> *v)
+	{
+		{
+			boost::unique_lock<boost::mutex> lock (mtx_);
+			while(queue_.size() >= max_queue_depth && !stop_)
+				not_full_.wait(lock);
+			if(stop_) {
+				delete v;
+				return false;
+			}
+			queue_.push_back(v);
+		}
+		not_empty_.notify_one();
+		return true;
+	}
+
+	static void run(Gzip_reader *me)
+	{
+		try {
+			if(me->inflate_bgzf())
+				me->inflate_stream();
+		} catch(std::exception &e) {
+			exception_state.set(e);
+			boost::lock_guard<boost::mutex> lock (me->mtx_);
+			me->failed_ = true;
+		}
+		{
+			boost::lock_guard<boost::mutex> lock (me->mtx_);
+			me->done_ = true;
+		}
+		me->not_empty_.notify_all();
+	}
+
+	/* Reads the header of the next member and returns its total size from
+	 * the BGZF extra field. Returns 0 at the end of the file and -1 if the
+	 * member is no BGZF block; the header bytes are appended to buf. */
+	long member_size(vector<char> &buf)
+	{
+		const size_t begin = buf.size();
+		buf.resize(begin + header_size);
+		const size_t n = fread(&buf[begin], 1, header_size, f_);
+		if(n == 0) {
+			buf.resize(begin);
+			return 0;
+		}
+		const unsigned char *h = (const unsigned char*)&buf[begin];
+		if(n < header_size || h[0] != 0x1f || h[1] != 0x8b || h[2] != 8 || (h[3] & 4) == 0)
+			return -1;
+		const size_t xlen = h[10] | (h[11] << 8);
+		buf.resize(begin + header_size + xlen);
+		if(fread(&buf[begin + header_size], 1, xlen, f_) != xlen)
+			return -1;
+		const unsigned char *x = (const unsigned char*)&buf[begin + header_size], *end = x + xlen;
+		for(;x+4<=end;x+=4+(x[2] | (x[3] << 8)))
+			if(x[0] == 'B' && x[1] == 'C' && (x[2] | (x[3] << 8)) == 2 && x+6<=end)
+				return (x[4] | (x[5] << 8)) + 1;
+		return -1;
+	}
+
+	/* Inflates the file as BGZF for as long as its members are BGZF
+	 * blocks. Returns true if the rest of the file, from the current
+	 * position on, needs to be inflated as a stream. */
+	bool inflate_bgzf()
+	{
+		vector<char> in;
+		vector<size_t> in_begin, out_begin;
+		for(;;) {
+			in.clear();
+			in_begin.clear();
+			out_begin.assign(1, 0);
+			long size = 0, member = 0;
+			while(out_begin.back() < block_size) {
+				member = ftell(f_);
+				const size_t b = in.size();
+				if((size = member_size(in)) <= 0) {
+					in.resize(b);
+					break;
+				}
+				const size_t header = in.size() - b;
+				if((size_t)size < header + 8)
+					THROW_EXCEPTION(file_io_exception, file_name);
+				in.resize(b + size);
+				if(fread(&in[b + header], 1, size - header, f_) != size - header)
+					THROW_EXCEPTION(file_io_exception, file_name);
+				const unsigned char *t = (const unsigned char*)&in[b + size - 4];
+				const size_t isize = t[0] | (t[1] << 8) | (t[2] << 16) | ((size_t)t[3] << 24);
+				if(isize > max_bgzf_block)
+					THROW_EXCEPTION(file_io_exception, file_name);
+				in_begin.push_back(b);
+				out_begin.push_back(out_begin.back() + isize);
+			}
+			in_begin.push_back(in.size());
+			if(!inflate_members(in, in_begin, out_begin) || size == 0)
+				return false;
+			if(size < 0) {
+				fseek(f_, member, SEEK_SET);
+				return true;
+			}
+		}
+	}
+
+	bool inflate_members(const vector<char> &in, const vector<size_t> &in_begin, const vector<size_t> &out_begin)
+	{
+		const long n = out_begin.size() - 1;
+		if(n == 0)
+			return true;
+		vector<char> *out = new vector<char> (out_begin.back());
+		vector<char> ok (n, 1);
+		unsigned threads;
+		{
+			boost::lock_guard<boost::mutex> lock (mtx_);
+			threads = threads_;
+		}
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+		for(long i=0;i<n;++i) {
+			const size_t expected = out_begin[i+1] - out_begin[i];
+			char empty;
+			z_stream z;
+			memset(&z, 0, sizeof(z));
+			z.next_in = (Bytef*)&in[in_begin[i]];
+			z.avail_in = in_begin[i+1] - in_begin[i];
+			z.next_out = expected ? (Bytef*)&(*out)[out_begin[i]] : (Bytef*)&empty;
+			z.avail_out = expected ? expected : 1;
+			if(inflateInit2(&z, 16 + MAX_WBITS) != Z_OK)
+				ok[i] = 0;
+			else {
+				if(inflate(&z, Z_FINISH) != Z_STREAM_END || z.total_out != expected)
+					ok[i] = 0;
+				inflateEnd(&z);
+			}
+		}
+		if(std::find(ok.begin(), ok.end(), 0) != ok.end()) {
+			delete out;
+			THROW_EXCEPTION(file_io_exception, file_name);
+		}
+		return push(out);
+	}
+
+	void inflate_stream()
+	{
+		vector<char> in (1<<20);
+		z_stream z;
+		memset(&z, 0, sizeof(z));
+		if(inflateInit2(&z, 16 + MAX_WBITS) != Z_OK)
+			THROW_EXCEPTION(file_io_exception, file_name);
+		auto_ptr<vector<char> > out (new vector<char> (block_size));
+		size_t n = 0;
+		bool member_end = false;
+		for(;;) {
+			if(z.avail_in == 0) {
+				z.next_in = (Bytef*)in.data();
+				if((z.avail_in = fread(in.data(), 1, in.size(), f_)) == 0)
+					break;
+			}
+			if(member_end) {
+				inflateReset(&z);
+				member_end = false;
+			}
+			z.next_out = (Bytef*)out->data() + n;
+			z.avail_out = block_size - n;
+			const int r = inflate(&z, Z_NO_FLUSH);
+			n = block_size - z.avail_out;
+			if(r == Z_STREAM_END)
+				member_end = true;
+			else if(r != Z_OK && r != Z_BUF_ERROR) {
+				inflateEnd(&z);
+				THROW_EXCEPTION(file_io_exception, file_name);
+			}
+			if(n == block_size) {
+				if(!push(out.release())) {
+					inflateEnd(&z);
+					return;
+				}
+				out.reset(new vector<char> (block_size));
+				n = 0;
+			}
+		}
+		inflateEnd(&z);
+		if(!member_end || ferror(f_))
+			THROW_EXCEPTION(file_io_exception, file_name);
+		out->resize(n);
+		push(out.release());
+	}
+
+	FILE *f_;
+	thread *thread_;
+	vector<char> *block_;
+	size_t pos_;
+	unsigned threads_;
+	std::deque<vector<char>*> queue_;
+	boost::mutex mtx_;
+	boost::condition_variable not_empty_, not_full_;
+	bool done_, failed_, stop_;
+
+};
+
+#endif /* GZIP_READER_H_ */
@@ -0,0 +1,106 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef RADIX_SORT_H_
+#define RADIX_SORT_H_
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+using std::vector;
+
+/* Stable LSD radix sort on the lowest key_bits bits of key(x), 11 bits per pass.
+   buffer must hold end-begin elements. */
+
+template<typename _t, typename _key>
+void radix_sort(_t *begin, _t *end, _t *buffer, unsigned key_bits, const _key &key)
+{
+	enum { radix_bits = 11, radix = 1 << radix_bits };
+	const size_t n = end - begin;
+	if(n < 2)
+		return;
+	size_t count[radix];
+	_t *src = begin, *dst = buffer;
+	for(unsigned shift=0;shift<key_bits;shift+=radix_bits) {
+		memset(count, 0, sizeof(count));
+		for(const _t *i=src;i<src+n;++i)
+			++count[(key(*i) >> shift) & (radix-1)];
+		if(count[(key(*src) >> shift) & (radix-1)] == n)
+			continue;
+		size_t sum = 0;
+		for(unsigned i=0;i<radix;++i) {
+			const size_t c = count[i];
+			count[i] = sum;
+			sum += c;
+		}
+		for(const _t *i=src;i<src+n;++i)
+			dst[count[(key(*i) >> shift) & (radix-1)]++] = *i;
+		std::swap(src, dst);
+	}
+	if(src != begin)
+		memcpy(begin, src, n*sizeof(_t));
+}
+
+/* Stable counting sort for dense keys in [key_min, key_max]. Each thread counts
+   and scatters one contiguous slice of the input, so the order of equal keys is kept.
+   The number of threads is capped so that the per-thread counts take no more
+   entries than the input, and the counts are scanned one thread row at a time.
+   buffer must hold end-begin elements, the result is written back to [begin,end). */
+
+template<typename _t, typename _key>
+void counting_sort(_t *begin, _t *end, _t *buffer, size_t key_min, size_t key_max, unsigned threads, const _key &key)
+{
+	const size_t n = end - begin, keys = key_max - key_min + 1;
+	if(n < 2)
+		return;
+	threads = (unsigned)std::max((size_t)1, std::min((size_t)threads, std::min(n / 65536 + 1, n / keys)));
+	vector<size_t> count (keys * threads), base (keys);
+#pragma omp parallel for num_threads(threads)
+	for(int t=0;t<(int)threads;++t) {
+		size_t *c = &count[t*keys];
+		for(const _t *i=begin+n*t/threads;i<begin+n*(t+1)/threads;++i)
+			++c[key(*i) - key_min];
+	}
+	for(unsigned t=0;t<threads;++t)
+		for(size_t k=0;k<keys;++k)
+			base[k] += count[t*keys+k];
+	size_t sum = 0;
+	for(size_t k=0;k<keys;++k) {
+		const size_t c = base[k];
+		base[k] = sum;
+		sum += c;
+	}
+	for(unsigned t=0;t<threads;++t)
+		for(size_t k=0;k<keys;++k) {
+			const size_t c = count[t*keys+k];
+			count[t*keys+k] = base[k];
+			base[k] += c;
+		}
+#pragma omp parallel for num_threads(threads)
+	for(int t=0;t<(int)threads;++t) {
+		size_t *c = &count[t*keys];
+		for(const _t *i=begin+n*t/threads;i<begin+n*(t+1)/threads;++i)
+			buffer[c[key(*i) - key_min]++] = *i;
+	}
+	memcpy(begin, buffer, n*sizeof(_t));
+}
+
+#endif /* RADIX_SORT_H_ */
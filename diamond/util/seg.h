@@ -0,0 +1,375 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef SEG_H_
+#define SEG_H_
+
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include "../algo/blast/core/blast_seg.h"
+#include "../algo/blast/core/ncbi_math.h"
+
+using std::vector;
+
+/* The SEG algorithm of Wootton and Federhen as implemented in
+ * algo/blast/core/blast_seg.c (SeqBufferSeg with the protein defaults of
+ * SegParametersNewAa), giving the same segments. The window composition
+ * slides along with a key packing how many letters occur once, twice,
+ * etc., which determines the state vector and thus the entropy; the
+ * entropy class of the window is memoized under that key. Entropies are
+ * summed from a table over the state vector in the order of blast_seg.c,
+ * and all buffers are kept between calls, so that a per thread instance
+ * does no allocations once warmed up. SeqBufferSeg merges overlapping
+ * segments (s_MergeSegs) only if SegParameters::overlaps is set, which the
+ * protein defaults leave off, so there is no merge step here either. */
+
+struct Seg
+{
+
+	struct Segment
+	{
+		Segment(int begin, int end):
+			begin (begin),
+			end (end)
+		{ }
+		int begin, end;
+	};
+
+	Seg():
+		memo_count_ (0)
+	{
+		SegParameters *p = SegParametersNewAa();
+		window_ = p->window;
+		locut_ = p->locut;
+		hicut_ = p->hicut;
+		maxtrim_ = p->maxtrim;
+		maxbogus_ = p->maxbogus;
+		SegParametersFree(p);
+		entropy_.resize((window_+1)*(window_+1));
+		for(int total=1;total<=window_;++total)
+			for(int c=1;c<=total;++c)
+				entropy_[total*(window_+1)+c] = ((double)c)*log(((double)c)/(double)total)/NCBIMATH_LN2;
+	}
+
+	/* Returns the segments of the sequence (0 based, inclusive ends). */
+	const vector<Segment>& operator()(const char *seq, int len)
+	{
+		segs_.clear();
+		seg(seq, len, 0, 0);
+		return segs_;
+	}
+
+private:
+
+	enum { alphasize = 20 };
+	enum { invalid, low, mid, high };
+	enum { memo_bits = 10, memo_size = 1 << memo_bits, max_key_window = 15 };
+	static const uint64_t no_key = ~(uint64_t)0;
+
+	struct Memo
+	{
+		Memo():
+			key (no_key),
+			cls (invalid)
+		{ }
+		uint64_t key;
+		unsigned char cls;
+	};
+
+	/* Composition and state vector (sorted counts, 0 terminated) of a window. */
+	struct Window
+	{
+		void open(const char *s, int len)
+		{
+			seq = s;
+			length = len;
+			bogus = 0;
+			std::fill(comp, comp+alphasize, 0);
+			for(int i=0;i<len;++i)
+				if((unsigned)s[i] < alphasize)
+					++comp[(int)s[i]];
+				else
+					++bogus;
+			int n = 0;
+			for(int l=0;l<alphasize;++l)
+				if(comp[l] != 0)
+					state[n++] = comp[l];
+			std::fill(state+n, state+alphasize+1, 0);
+			std::sort(state, state+n, std::greater<int>());
+		}
+		void shift()
+		{
+			const unsigned a = seq[0], b = seq[length];
+			if(a < alphasize)
+				decrement(comp[a]--);
+			else
+				--bogus;
+			if(b < alphasize)
+				increment(comp[b]++);
+			else
+				++bogus;
+			++seq;
+		}
+		void decrement(int c)
+		{
+			int *sv = state;
+			while(*sv != c || sv[1] == c)
+				++sv;
+			--*sv;
+		}
+		void increment(int c)
+		{
+			int *sv = state;
+			while(*sv != c)
+				++sv;
+			++*sv;
+		}
+		const char *seq;
+		int length, bogus, comp[alphasize], state[alphasize+1];
+	};
+
+	/* total is the sum of the state vector. */
+	double entropy(const int *sv, int total) const
+	{
+		if(total == 0)
+			return 0.;
+		const double *e = &entropy_[total*(window_+1)];
+		double ent = 0.0;
+		for(int i=0;sv[i]!=0;++i)
+			ent += e[sv[i]];
+		return fabs(ent/(double)total);
+	}
+
+	unsigned char classify(double e) const
+	{ return e <= locut_ ? low : (e > hicut_ ? high : mid); }
+
+	/* Nibble c-1 of key holds the number of letters occurring c times in a
+	 * window of up to 15 letters. */
+	static void add(unsigned l, int *comp, int &bogus, uint64_t &key)
+	{
+		if(l < alphasize) {
+			const int c = comp[l]++;
+			if(c > 0)
+				key -= (uint64_t)1 << 4*(c-1);
+			key += (uint64_t)1 << 4*c;
+		} else
+			++bogus;
+	}
+
+	static void remove(unsigned l, int *comp, int &bogus, uint64_t &key)
+	{
+		if(l < alphasize) {
+			const int c = comp[l]--;
+			key -= (uint64_t)1 << 4*(c-1);
+			if(c > 1)
+				key += (uint64_t)1 << 4*(c-2);
+		} else
+			--bogus;
+	}
+
+	/* At most memo_size-1 keys are stored, so a probe always ends on the key
+	 * or an empty slot; once the memo is full, new keys are classified
+	 * without being stored. Windows of up to 15 letters have fewer than 700
+	 * distinct keys, so this does not happen with the supported windows. */
+	unsigned char classify(uint64_t key, int total)
+	{
+		size_t i = (size_t)((key * 0x9E3779B97F4A7C15ULL) >> (64 - memo_bits));
+		while(memo_[i].key != key) {
+			if(memo_[i].key == no_key) {
+				int sv[alphasize+1], n = 0;
+				for(int c=max_key_window;c>0;--c)
+					for(unsigned k=(key>>4*(c-1))&15;k>0;--k)
+						sv[n++] = c;
+				sv[n] = 0;
+				const unsigned char cls = classify(entropy(sv, total));
+				if(memo_count_ < memo_size - 1) {
+					memo_[i].key = key;
+					memo_[i].cls = cls;
+					++memo_count_;
+				}
+				return cls;
+			}
+			i = (i + 1) & (memo_size - 1);
+		}
+		return memo_[i].cls;
+	}
+
+	/* The FMA contractions that -march=native allows in C++ would change
+	 * the results against the C code, so products feeding a sum are kept
+	 * in volatiles. */
+	static double ln_fact(int n)
+	{
+		if(n < kSegLnfactSize)
+			return lnfact[n];
+		const volatile double p = (n+0.5)*log(n);
+		return p - n + 0.9189385332;
+	}
+
+	static double ln_perm(const int *sv, int window_length)
+	{
+		double ans = ln_fact(window_length);
+		for(int i=0;sv[i]!=0;++i)
+			ans -= ln_fact(sv[i]);
+		return ans;
+	}
+
+	static double ln_ass(const int *sv)
+	{
+		double ans = lnfact[alphasize];
+		if(sv[0] == 0)
+			return ans;
+		int total = alphasize, cls = 1, svi = sv[0], svim1 = sv[0];
+		for(int i=0;;svim1 = svi) {
+			if(++i == alphasize) {
+				ans -= ln_fact(cls);
+				break;
+			} else if((svi = *++sv) == svim1) {
+				++cls;
+			} else {
+				total -= cls;
+				ans -= ln_fact(cls);
+				if(svi == 0) {
+					ans -= ln_fact(total);
+					break;
+				}
+				cls = 1;
+			}
+		}
+		return ans;
+	}
+
+	static double prob(const int *sv, int total)
+	{
+		const volatile double totseq = ((double)total) * 2.9957322735539909;
+		return ln_ass(sv) + ln_perm(sv, total) - totseq;
+	}
+
+	/* Narrows [leftend, rightend] to the subwindow of least probability, seq
+	 * being its first letter. */
+	void trim(const char *seq, int &leftend, int &rightend)
+	{
+		const int length = rightend - leftend + 1;
+		int lend = 0, rend = length - 1, minlen = 1;
+		if(length - maxtrim_ > minlen)
+			minlen = length - maxtrim_;
+		double minprob = 1.;
+		for(int len=length;len>minlen;--len) {
+			window_state_.open(seq, len);
+			for(int i=0;;++i) {
+				const double p = prob(window_state_.state, len);
+				if(p < minprob) {
+					minprob = p;
+					lend = i;
+					rend = len + i - 1;
+				}
+				if(i + len >= length)
+					break;
+				window_state_.shift();
+			}
+		}
+		leftend += lend;
+		rightend -= length - rend - 1;
+	}
+
+	/* Classifies the entropy of the windows centered on each position into
+	 * h_[top, top+len). */
+	void entropies(const char *seq, int len, size_t top)
+	{
+		const int downset = (window_+1)/2 - 1, upset = window_ - downset, last = len - upset;
+		unsigned char *h = &h_[top];
+		std::fill(h, h+len, (unsigned char)invalid);
+		if(window_ > max_key_window) {
+			window_state_.open(seq, window_);
+			for(int i=downset;i<=last;++i) {
+				if(window_state_.bogus <= maxbogus_)
+					h[i] = classify(entropy(window_state_.state, window_ - window_state_.bogus));
+				if(i < last)
+					window_state_.shift();
+			}
+			return;
+		}
+		int comp[alphasize], bogus = 0;
+		uint64_t key = 0;
+		std::fill(comp, comp+alphasize, 0);
+		for(int j=0;j<window_;++j)
+			add(seq[j], comp, bogus, key);
+		for(int i=downset;i<=last;++i) {
+			if(bogus <= maxbogus_)
+				h[i] = classify(key, window_ - bogus);
+			if(i < last) {
+				remove(seq[i-downset], comp, bogus, key);
+				add(seq[i-downset+window_], comp, bogus, key);
+			}
+		}
+	}
+
+	/* s_SegSeq, with the entropies of each recursion level stacked in h_
+	 * from top on. */
+	void seg(const char *seq, int len, int offset, size_t top)
+	{
+		if(window_ > len)
+			return;
+		if(h_.size() < top + len)
+			h_.resize(top + len);
+		entropies(seq, len, top);
+		const int downset = (window_+1)/2 - 1, upset = window_ - downset, last = len - upset;
+		int lowlim = downset;
+		for(int i=downset;i<=last;++i) {
+			if(h_[top+i] != low)
+				continue;
+			int loi = i, hii = i;
+			while(loi >= lowlim && h_[top+loi] != invalid && h_[top+loi] != high)
+				--loi;
+			++loi;
+			while(hii <= last && h_[top+hii] != invalid && h_[top+hii] != high)
+				++hii;
+			--hii;
+			int leftend = loi - downset, rightend = hii + upset - 1;
+			trim(seq + leftend, leftend, rightend);
+			if(i + upset - 1 < leftend) {
+				const int lend = loi - downset, n = (int)segs_.size();
+				seg(seq + lend, leftend - lend, offset + lend, top + len);
+				// blast_seg.c links only the head of the list found on the left.
+				if((int)segs_.size() > n + 1) {
+					segs_[n] = segs_.back();
+					segs_.erase(segs_.begin() + n + 1, segs_.end());
+				}
+			}
+			segs_.push_back(Segment(leftend + offset, rightend + offset));
+			i = std::min(hii, rightend + downset);
+			lowlim = i + 1;
+		}
+	}
+
+	int window_, maxtrim_, maxbogus_;
+	double locut_, hicut_;
+	vector<double> entropy_;
+	vector<unsigned char> h_;
+	vector<Segment> segs_;
+	Window window_state_;
+	Memo memo_[memo_size];
+	unsigned memo_count_;
+
+};
+
+#endif /* SEG_H_ */
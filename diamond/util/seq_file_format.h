@@ -21,89 +21,96 @@ Author: Benjamin Buchfink
 #ifndef SEQ_FILE_FORMAT_H_
 #define SEQ_FILE_FORMAT_H_
 
+#include <string.h>
+#include <emmintrin.h>
+
 using std::pair;
 
+/* Location of one record in an input block. The sequence may span
+ * several lines; length is its number of letters. */
+struct Seq_record
+{
+	const char *id_begin, *id_end, *seq_begin, *seq_end;
+	size_t length;
+};
+
+size_t count_line_breaks(const char *p, const char *end)
+{
+	const __m128i nl (_mm_set1_epi8('\n')), cr (_mm_set1_epi8('\r'));
+	size_t n = 0;
+	for(;p+16<=end;p+=16) {
+		const __m128i x (_mm_loadu_si128((const __m128i*)p));
+		n += __builtin_popcount(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, nl), _mm_cmpeq_epi8(x, cr))));
+	}
+	for(;p<end;++p)
+		n += *p == '\n' || *p == '\r';
+	return n;
+}
+
+template<typename _t>
+void decode_seq(const char *p, const char *end, _t *dst)
+{
+	for(;p<end;++p)
+		if(*p != '\n' && *p != '\r')
+			*(dst++) = Value_traits<_t>::from_char(*p);
+}
+
 template<typename _val>
 struct Sequence_file_format
 {
 
-	virtual bool get_seq(vector<char> &id, vector<_val> &seq, Input_stream &s) const = 0;
+	/* Locates the record starting at p. Returns the end of the record, or
+	 * 0 if the block holds no complete record and more input follows. */
+	virtual const char* get_record(const char *p, const char *end, bool eof, Seq_record &r) const = 0;
 	virtual ~Sequence_file_format()
 	{ }
 
 protected:
 
-	template<typename _t>
-	static void copy_line(Input_stream &s, vector<_t> &v)
+	static const char* line_end(const char *p, const char *end, bool eof)
 	{
-		char a = 0;
-		while(s.read(&a, 1) == 1 && a != '\n' && a != '\r')
-			v.push_back(Value_traits<_t>::from_char(a));
-		if(a == '\r')
-			if(s.read(&a, 1) != 1 || a != '\n')
-				throw file_format_exception ();
+		const char *q = (const char*)memchr(p, '\n', end - p);
+		return q ? q : (eof ? end : 0);
 	}
 
-	static void skip_line(Input_stream &s)
-	{
-		char a = 0;
-		while(s.read(&a, 1) == 1 && a != '\n' && a != '\r');
-		if(a == '\r')
-			if(s.read(&a, 1) != 1 || a != '\n')
-				throw file_format_exception ();
-	}
+	static const char* next_line(const char *p, const char *end)
+	{ return p < end ? p + 1 : end; }
 
-	static void copy_until(Input_stream &s, int delimiter, vector<_val> &v)
-	{
-		char a = 0;
-		size_t n;
-		for(;;) {
-			while((n = s.read(&a, 1)) == 1 && a != '\n')
-				if(a != '\r')
-					v.push_back(Value_traits<_val>::from_char(a));
-			n = s.read(&a, 1);
-			if(n == 0)
-				return;
-			else if(a == delimiter) {
-				s.putback(a);
-				return;
-			} else
-				v.push_back(Value_traits<_val>::from_char(a));
-		}
-	}
-
-	static void skip_char(Input_stream &s, char c)
-	{
-		char a;
-		if(s.read(&a, 1) != 1 || a != c)
-			throw file_format_exception ();
-	}
-
-	static bool have_char(Input_stream &s, char c)
-	{
-		char a;
-		if(s.read(&a, 1) == 0)
-			return false;
-		else if (a != c)
-			throw file_format_exception ();
-		else
-			return true;
-	}
+	static const char* trim_cr(const char *begin, const char *end)
+	{ return end > begin && end[-1] == '\r' ? end - 1 : end; }
 
 };
 
 template<typename _val>
 struct FASTA_format : public Sequence_file_format<_val>
 {
-	virtual bool get_seq(vector<char> &id, vector<_val> &seq, Input_stream &s) const
+
+	virtual const char* get_record(const char *p, const char *end, bool eof, Seq_record &r) const
 	{
-		if(!Sequence_file_format<_val>::have_char(s, '>'))
-			return false;
-		id.clear();
-		seq.clear();
-		Sequence_file_format<_val>::copy_line(s, id);
-		Sequence_file_format<_val>::copy_until(s, '>', seq);
-		return true;
+		if(p == end)
+			return 0;
+		if(*p != '>')
+			throw file_format_exception ();
+		const char *q = Sequence_file_format<_val>::line_end(p, end, eof);
+		if(q == 0)
+			return 0;
+		r.id_begin = p + 1;
+		r.id_end = Sequence_file_format<_val>::trim_cr(r.id_begin, q);
+		r.seq_begin = Sequence_file_format<_val>::next_line(q, end);
+		for(q = r.seq_begin;;++q) {
+			q = (const char*)memchr(q, '>', end - q);
+			if(q == 0) {
+				if(!eof)
+					return 0;
+				q = end;
+				break;
+			}
+			if(q[-1] == '\n')
+				break;
+		}
+		r.seq_end = q;
+		r.length = (q - r.seq_begin) - count_line_breaks(r.seq_begin, q);
+		return q;
 	}
 
 	virtual ~FASTA_format()
@@ -115,18 +122,32 @@ template<typename _val>
 struct FASTQ_format : public Sequence_file_format<_val>
 {
 
-	virtual bool get_seq(vector<char> &id, vector<_val> &seq, Input_stream &s) const
+	virtual const char* get_record(const char *p, const char *end, bool eof, Seq_record &r) const
 	{
-		if(!Sequence_file_format<_val>::have_char(s, '@'))
-			return false;
-		id.clear();
-		seq.clear();
-		Sequence_file_format<_val>::copy_line(s, id);
-		Sequence_file_format<_val>::copy_line(s, seq);
-		Sequence_file_format<_val>::skip_char(s, '+');
-		Sequence_file_format<_val>::skip_line(s);
-		Sequence_file_format<_val>::skip_line(s);
-		return true;
+		typedef Sequence_file_format<_val> F;
+		if(p == end)
+			return 0;
+		if(*p != '@')
+			throw file_format_exception ();
+		const char *q = F::line_end(p, end, eof);
+		if(q == 0)
+			return 0;
+		r.id_begin = p + 1;
+		r.id_end = F::trim_cr(r.id_begin, q);
+		r.seq_begin = F::next_line(q, end);
+		if((q = F::line_end(r.seq_begin, end, eof)) == 0)
+			return 0;
+		r.seq_end = F::trim_cr(r.seq_begin, q);
+		r.length = r.seq_end - r.seq_begin;
+		p = F::next_line(q, end);
+		if(p == end && !eof)
+			return 0;
+		if(p == end || *p != '+')
+			throw file_format_exception ();
+		if((q = F::line_end(p, end, eof)) == 0
+				|| (q = F::line_end(F::next_line(q, end), end, eof)) == 0)
+			return 0;
+		return F::next_line(q, end);
 	}
 
 	virtual ~FASTQ_format()
@@ -48,4 +48,40 @@ bool check_SSSE3()
     return false;
 }
 
+bool check_os_xsave(uint64_t mask)
+{
+	int info[4];
+	cpuid(info, 1);
+	if((info[2] & (1<<27)) == 0)
+		return false;
+#ifdef _WIN32
+	const uint64_t xcr0 = _xgetbv(0);
+#else
+	uint32_t eax, edx;
+	__asm__ __volatile__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+	const uint64_t xcr0 = ((uint64_t)edx << 32) | eax;
+#endif
+	return (xcr0 & mask) == mask;
+}
+
+bool check_AVX2()
+{
+	int info[4];
+	cpuid(info, 0);
+	if(info[0] < 7 || !check_os_xsave(0x6))
+		return false;
+	cpuid(info, 7);
+	return (info[1] & (1<<5)) != 0;
+}
+
+bool check_AVX512BW()
+{
+	int info[4];
+	cpuid(info, 0);
+	if(info[0] < 7 || !check_os_xsave(0xe6))
+		return false;
+	cpuid(info, 7);
+	return (info[1] & (1<<16)) != 0 && (info[1] & (1<<30)) != 0;
+}
+
 #endif /* SYSTEM_H_ */
@@ -212,6 +212,34 @@ struct Pair
 	_t2 second;
 };
 
+inline void put_varint(vector<char> &buf, uint64_t x)
+{
+	while(x >= 0x80) {
+		buf.push_back(char(x | 0x80));
+		x >>= 7;
+	}
+	buf.push_back(char(x));
+}
+
+inline uint64_t get_varint(const char *&ptr)
+{
+	uint64_t x = 0;
+	unsigned shift = 0;
+	uint8_t c;
+	do {
+		c = *(ptr++);
+		x |= uint64_t(c & 0x7f) << shift;
+		shift += 7;
+	} while(c & 0x80);
+	return x;
+}
+
+inline uint64_t zigzag(int64_t x)
+{ return (uint64_t(x) << 1) ^ uint64_t(x >> 63); }
+
+inline int64_t unzigzag(uint64_t x)
+{ return int64_t(x >> 1) ^ -int64_t(x & 1); }
+
 size_t find_first_of(const char *s, const char *delimiters)
 {
 	const char *t = s;
@@ -0,0 +1,104 @@
+/****
+Copyright (c) 2014, University of Tuebingen
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****
+Author: Benjamin Buchfink
+****/
+
+#ifndef WORK_QUEUE_H_
+#define WORK_QUEUE_H_
+
+#include <vector>
+#include <deque>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+using std::vector;
+using std::deque;
+
+/* Work stealing queue: tasks are dealt round robin to one deque per
+ * thread. A thread takes its own tasks from the front and, once its deque
+ * is empty, steals from the back of the other deques. */
+
+template<typename _t>
+struct Work_queue
+{
+
+	Work_queue(const vector<_t> &tasks, unsigned threads)
+	{
+		for(unsigned i=0;i<threads;++i)
+			queues_.push_back(new Queue ());
+		for(size_t i=0;i<tasks.size();++i)
+			queues_[i%threads].tasks.push_back(tasks[i]);
+	}
+
+	// thread numbers beyond the number of queues share a queue
+	bool get(unsigned thread, _t &task)
+	{
+		const unsigned own = thread % queues_.size();
+		if(queues_[own].pop_front(task))
+			return true;
+		for(unsigned i=1;i<queues_.size();++i)
+			if(queues_[(own+i)%queues_.size()].pop_back(task))
+				return true;
+		return false;
+	}
+
+	size_t steals() const
+	{
+		size_t n (0);
+		for(unsigned i=0;i<queues_.size();++i)
+			n += queues_[i].stolen;
+		return n;
+	}
+
+private:
+
+	struct Queue
+	{
+		Queue():
+			stolen (0)
+		{ }
+		bool pop_front(_t &task)
+		{
+			boost::lock_guard<boost::mutex> lock (mtx);
+			if(tasks.empty())
+				return false;
+			task = tasks.front();
+			tasks.pop_front();
+			return true;
+		}
+		bool pop_back(_t &task)
+		{
+			boost::lock_guard<boost::mutex> lock (mtx);
+			if(tasks.empty())
+				return false;
+			task = tasks.back();
+			tasks.pop_back();
+			++stolen;
+			return true;
+		}
+		deque<_t> tasks;
+		boost::mutex mtx;
+		size_t stolen;
+	};
+
+	boost::ptr_vector<Queue> queues_;
+
+};
+
+#endif /* WORK_QUEUE_H_ */